@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "sll_meta.h"
+
+/*
+ * per operation benchmark driver with baselines and significance testing
+ *
+ * every benchmark is run REPEATS times (-r), each run timing NODES operations and yielding one
+ * ns/op sample. Samples are written as a JSON object of arrays with -o, and with -b a previous
+ * such file is read as the baseline and every operation is compared against it with a two sided
+ * Mann-Whitney U test. The shift is reported as the Hodges-Lehmann estimate with its confidence
+ * interval, relative to the baseline median, and an operation is flagged as a regression when the
+ * difference is significant (-a, default 0.05) and the estimated slowdown exceeds the threshold
+ * (-t, in percent, default 5). The exit status is 1 if anything regressed.
+ *
+ * bench_ops [-r repeats] [-o results.json] [-b baseline.json] [-t percent] [-a alpha]
+ */
+
+#define NODES      (1024*1024)
+#define REPEATS    15
+#define MAXREPEATS 1000
+
+typedef struct benchnode {
+	SLL_LINK(benchnode);
+	uint64_t payload[3];
+} benchnode;
+
+SLL_DECLS(bench, benchnode, benchlist);
+SLL_ITER_DECLS(bench, benchnode, benchlist, benchiter);
+SLL_POOL_DECLS(bench, benchnode, benchlist, benchpool);
+
+SLL_DEFS(bench, benchnode, benchlist, free);
+SLL_ITER_DEFS(bench, benchnode, benchlist, benchiter);
+SLL_POOL_DEFS(bench, benchnode, benchlist, benchpool);
+
+static benchnode *nodes;
+static benchlist list;
+static benchpool pool;
+static volatile uint64_t sink;
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void fill(void) {
+	bench_lclear(&list);
+	for (size_t i=0; i<NODES; ++i) {
+		bench_lpushback(&list, &nodes[i]);
+	}
+}
+
+static double run_lpushback(void) {
+	bench_lclear(&list);
+	double t0 = now();
+	for (size_t i=0; i<NODES; ++i) {
+		bench_lpushback(&list, &nodes[i]);
+	}
+	return now() - t0;
+}
+
+static double run_lpopfront(void) {
+	fill();
+	uint64_t sum = 0;
+	double t0 = now();
+	for (size_t i=0; i<NODES; ++i) {
+		sum += bench_lpopfront(&list)->payload[0];
+	}
+	double t = now() - t0;
+	sink = sum;
+	return t;
+}
+
+static double run_iterate(void) {
+	fill();
+	uint64_t sum = 0;
+	double t0 = now();
+	for (benchiter iter=SLL_ISTART(&list); !bench_iisend(&iter); bench_inext(&iter)) {
+		sum += bench_iget(&iter)->payload[0];
+	}
+	double t = now() - t0;
+	sink = sum;
+	return t;
+}
+
+static double run_pget(void) {
+	/* the pool holds NODES nodes between runs, so this times reuse rather than calloc */
+	bench_lclear(&list);
+	double t0 = now();
+	for (size_t i=0; i<NODES; ++i) {
+		bench_lpushback(&list, bench_pget(&pool));
+	}
+	double t = now() - t0;
+	bench_lsplice(&pool, &list);
+	return t;
+}
+
+static const struct {
+	const char *name;
+	double (*run)(void);
+} benchmarks[] = {
+	{ "lpushback", run_lpushback },
+	{ "lpopfront", run_lpopfront },
+	{ "iterate",   run_iterate },
+	{ "pget",      run_pget },
+};
+
+#define NBENCH (sizeof(benchmarks) / sizeof(benchmarks[0]))
+
+typedef struct {
+	double v[MAXREPEATS];
+	size_t n;
+} samples;
+
+static int cmpdouble(const void *a, const void *b) {
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+typedef struct {
+	double v;  // first, so that cmpdouble sorts these by value
+	bool fromx;
+} ranked;
+
+static double median(const samples *s) {
+	double sorted[MAXREPEATS];
+	memcpy(sorted, s->v, s->n * sizeof(double));
+	qsort(sorted, s->n, sizeof(double), cmpdouble);
+	return s->n % 2 ? sorted[s->n / 2] : (sorted[s->n / 2 - 1] + sorted[s->n / 2]) / 2;
+}
+
+static int save(const char *path, const samples *results) {
+	FILE *f = fopen(path, "w");
+	if (f == NULL) { return -1; }
+	fprintf(f, "{\n");
+	for (size_t b=0; b<NBENCH; ++b) {
+		fprintf(f, "  \"%s\": [", benchmarks[b].name);
+		for (size_t i=0; i<results[b].n; ++i) {
+			fprintf(f, "%s%.4f", i > 0 ? ", " : "", results[b].v[i]);
+		}
+		fprintf(f, "]%s\n", b + 1 < NBENCH ? "," : "");
+	}
+	fprintf(f, "}\n");
+	return fclose(f);
+}
+
+// reads back what save wrote, operations missing from the file are left empty
+static int load(const char *path, samples *results) {
+	FILE *f = fopen(path, "r");
+	if (f == NULL) { return -1; }
+	char buf[65536];
+	size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+	fclose(f);
+	buf[len] = '\0';
+	for (size_t b=0; b<NBENCH; ++b) {
+		char key[64];
+		snprintf(key, sizeof(key), "\"%s\"", benchmarks[b].name);
+		results[b].n = 0;
+		char *p = strstr(buf, key);
+		if (p == NULL || (p = strchr(p, '[')) == NULL) { continue; }
+		++p;
+		while (results[b].n < MAXREPEATS) {
+			char *end;
+			double v = strtod(p, &end);
+			if (end == p) { break; }
+			results[b].v[results[b].n++] = v;
+			p = end + strspn(end, ", \t\n");
+		}
+	}
+	return 0;
+}
+
+/*
+ * two sided Mann-Whitney U test with the normal approximation and tie correction, which is
+ * adequate from about 8 samples per side, returns the p value
+ */
+static double mannwhitney(const samples *x, const samples *y) {
+	size_t m = x->n, n = y->n, N = m + n;
+	ranked all[2 * MAXREPEATS];
+	for (size_t i=0; i<m; ++i) { all[i].v = x->v[i]; all[i].fromx = true; }
+	for (size_t i=0; i<n; ++i) { all[m + i].v = y->v[i]; all[m + i].fromx = false; }
+	qsort(all, N, sizeof(ranked), cmpdouble);
+	double rx = 0, ties = 0;
+	for (size_t i=0; i<N; ) {
+		size_t j = i;
+		while (j < N && all[j].v == all[i].v) { ++j; }
+		double rank = (i + 1 + j) / 2.0, t = (double)(j - i);
+		for (size_t k=i; k<j; ++k) { if (all[k].fromx) { rx += rank; } }
+		ties += t * t * t - t;
+		i = j;
+	}
+	double u = rx - m * (m + 1) / 2.0;
+	double mu = m * n / 2.0;
+	double sigma = sqrt(m * n / 12.0 * ((N + 1) - ties / (N * (N - 1.0))));
+	if (sigma == 0) { return 1; }
+	double z = (fabs(u - mu) - 0.5) / sigma;
+	if (z < 0) { z = 0; }
+	return erfc(z / sqrt(2));
+}
+
+/*
+ * Hodges-Lehmann estimate of the shift y - x, the median of all pairwise differences, with the
+ * distribution free confidence interval at level 1 - alpha read off the sorted differences
+ */
+static double hodgeslehmann(const samples *x, const samples *y, double alpha, double *lo, double *hi) {
+	size_t m = x->n, n = y->n, mn = m * n;
+	double *d = malloc(mn * sizeof(double));
+	if (d == NULL) { *lo = *hi = 0; return 0; }
+	for (size_t i=0; i<m; ++i) {
+		for (size_t j=0; j<n; ++j) { d[i * n + j] = y->v[j] - x->v[i]; }
+	}
+	qsort(d, mn, sizeof(double), cmpdouble);
+	/* inverse of the normal tail by bisection, there is no erfcinv in libm */
+	double zl = 0, zh = 10;
+	for (int i=0; i<60; ++i) {
+		double z = (zl + zh) / 2;
+		if (erfc(z / sqrt(2)) > alpha) { zl = z; } else { zh = z; }
+	}
+	double k = floor(mn / 2.0 - zl * sqrt(m * n * (m + n + 1) / 12.0));
+	/* the bounds are the K-th smallest and K-th largest differences, counting from 1 */
+	size_t K = k < 1 ? 1 : (size_t)k;
+	*lo = d[K - 1];
+	*hi = d[mn - K];
+	double est = mn % 2 ? d[mn / 2] : (d[mn / 2 - 1] + d[mn / 2]) / 2;
+	free(d);
+	return est;
+}
+
+static void usage(const char *argv0) {
+	fprintf(stderr, "usage: %s [-r repeats] [-o results.json] [-b baseline.json] [-t percent] [-a alpha]\n", argv0);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	size_t repeats = REPEATS;
+	const char *out = NULL, *baseline = NULL;
+	double threshold = 5, alpha = 0.05;
+	int opt;
+	while ((opt = getopt(argc, argv, "r:o:b:t:a:")) != -1) {
+		switch (opt) {
+		case 'r': repeats = strtoul(optarg, NULL, 10); break;
+		case 'o': out = optarg; break;
+		case 'b': baseline = optarg; break;
+		case 't': threshold = strtod(optarg, NULL); break;
+		case 'a': alpha = strtod(optarg, NULL); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (repeats < 1 || repeats > MAXREPEATS || alpha <= 0 || alpha >= 1) { usage(argv[0]); }
+
+	static samples results[NBENCH], base[NBENCH];
+	nodes = calloc(NODES, sizeof(benchnode));
+	if (nodes == NULL) { perror("calloc"); return 2; }
+	for (size_t i=0; i<NODES; ++i) { nodes[i].payload[0] = i; }
+	bench_pclear(&pool);
+	for (size_t i=0; i<NODES; ++i) {
+		benchnode *node = calloc(1, sizeof(benchnode));
+		if (node == NULL) { perror("calloc"); return 2; }
+		bench_preturn(&pool, node);
+	}
+
+	/* interleave the benchmarks so that slow drift on the host hits all of them alike */
+	for (size_t r=0; r<repeats; ++r) {
+		for (size_t b=0; b<NBENCH; ++b) {
+			results[b].v[results[b].n++] = benchmarks[b].run() * 1e9 / NODES;
+		}
+	}
+
+	if (baseline != NULL && load(baseline, base) < 0) {
+		perror(baseline);
+		return 2;
+	}
+	int regressed = 0;
+	for (size_t b=0; b<NBENCH; ++b) {
+		double med = median(&results[b]);
+		printf("%-10s %8.3f ns/op (median of %zu)", benchmarks[b].name, med, results[b].n);
+		if (baseline != NULL && base[b].n > 0) {
+			double bmed = median(&base[b]), lo, hi;
+			double p = mannwhitney(&base[b], &results[b]);
+			double shift = hodgeslehmann(&base[b], &results[b], alpha, &lo, &hi);
+			bool slower = p < alpha && 100 * shift / bmed > threshold;
+			printf("  vs %8.3f: %+6.1f%% [%+6.1f%%, %+6.1f%%] p=%.4f%s",
+			       bmed, 100 * shift / bmed, 100 * lo / bmed, 100 * hi / bmed, p,
+			       slower ? "  REGRESSION" : p < alpha && shift < 0 ? "  improved" : "");
+			regressed |= slower;
+		}
+		printf("\n");
+	}
+
+	if (out != NULL && save(out, results) != 0) {
+		perror(out);
+		return 2;
+	}
+	bench_lclear(&list);
+	bench_pfree(&pool);
+	free(nodes);
+	return regressed;
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "sll_meta.h"
+#include "sll_slab.h"
+
+/*
+ * list traversal after churn, plain pool (SLL_POOL_DEFS) against slab pool (SLL_SLAB_DEFS)
+ *
+ * a list of LIVE nodes is built, then nodes are removed at random positions with ipop and returned
+ * to the pool, and as many are taken from the pool again and appended, for CYCLES removals in total.
+ * Afterwards the list is traversed a number of times, reporting the time per node and how many
+ * links stay within the same page.
+ */
+
+#define LIVE   (256*1024)
+#define CYCLES (1000*1000)
+#define WALKS  20
+
+typedef struct benchnode {
+	SLL_LINK(benchnode);
+	uint64_t payload[3];
+} benchnode;
+
+static void nofree(benchnode *node);
+
+SLL_DECLS(bench, benchnode, benchlist);
+SLL_ITER_DECLS(bench, benchnode, benchlist, benchiter);
+SLL_POOL_DECLS(bench, benchnode, benchlist, benchpool);
+SLL_SLAB_DECLS(bench, benchnode, benchlist, benchslabpool);
+
+SLL_DEFS(bench, benchnode, benchlist, nofree);
+SLL_ITER_DEFS(bench, benchnode, benchlist, benchiter);
+SLL_POOL_DEFS(bench, benchnode, benchlist, benchpool);
+SLL_SLAB_DEFS(bench, benchnode, benchlist, benchslabpool);
+
+static void nofree(benchnode *node) {
+	(void)node;
+}
+
+static uint64_t rng = 88172645463325252u;
+static uint64_t xorshift(void) {
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return rng;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *name, benchlist *list) {
+	uint64_t sum = 0;
+	size_t samepage = 0;
+	double t0 = now();
+	for (size_t w=0; w<WALKS; ++w) {
+		for (benchnode *node = list->first; node != NULL; node = SLL_NEXT(node)) {
+			sum += node->payload[0];
+		}
+	}
+	double t1 = now();
+	for (benchnode *node = list->first; node != NULL && SLL_NEXT(node) != NULL; node = SLL_NEXT(node)) {
+		if (((uintptr_t)node >> 12) == ((uintptr_t)SLL_NEXT(node) >> 12)) {
+			++samepage;
+		}
+	}
+	printf("%-6s %8.2f ns/node, %5.1f%% of links within a page (checksum %llu)\n",
+	       name, (t1 - t0) * 1e9 / (WALKS * (double)list->n), 100.0 * samepage / list->n, (unsigned long long)sum);
+}
+
+#define CHURN(get, ret, pool) do { \
+	size_t removed = 0; \
+	while (removed < CYCLES) { \
+		size_t round = 0; \
+		for (benchiter iter=SLL_ISTART(&list); !bench_iisend(&iter); bench_inext(&iter)) { \
+			if ((xorshift() & 7) == 0) { \
+				benchnode *node = bench_ipop(&iter); \
+				ret(pool, node); \
+				++round; \
+			} \
+		} \
+		for (size_t i=0; i<round; ++i) { \
+			benchnode *node = get(pool); \
+			node->payload[0] = i; \
+			bench_lpushback(&list, node); \
+		} \
+		removed += round; \
+	} \
+} while (0)
+
+int main(void) {
+	benchlist list;
+
+	benchpool pool;
+	bench_pclear(&pool);
+	bench_lclear(&list);
+	for (size_t i=0; i<LIVE; ++i) {
+		benchnode *node = bench_pget(&pool);
+		node->payload[0] = i;
+		bench_lpushback(&list, node);
+	}
+	report("fresh", &list);
+	CHURN(bench_pget, bench_preturn, &pool);
+	report("pool", &list);
+	while (bench_lsize(&list) > 0) {
+		free(bench_lpopfront(&list));
+	}
+	while (bench_lsize(&pool) > 0) {
+		free(bench_pget(&pool));
+	}
+
+	benchslabpool slabpool;
+	bench_spinit(&slabpool);
+	for (size_t i=0; i<LIVE; ++i) {
+		benchnode *node = bench_spget(&slabpool);
+		node->payload[0] = i;
+		bench_lpushback(&list, node);
+	}
+	CHURN(bench_spget, bench_spreturn, &slabpool);
+	report("slab", &list);
+	bench_lclear(&list);
+	bench_spfree(&slabpool);
+	return 0;
+}
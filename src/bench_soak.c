@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <time.h>
+#include <unistd.h>
+#include "sll_meta.h"
+
+/*
+ * long running churn soak of the list and the plain pool (SLL_POOL_DEFS)
+ *
+ * a list of about LIVE nodes (-l) is churned in rounds until the operation budget (-n) or the
+ * duration (-d, in seconds) runs out, whichever comes first. Every round the target size takes a
+ * random step, a pass with the iterator ipops random nodes and returns them to the pool, nodes are
+ * taken from the pool again and appended until the target is reached, and now and then the pool is
+ * trimmed with ptrim, handing memory back to malloc. Every interval (-i, in seconds) a sample goes
+ * to the time series (-o, default stdout) as a CSV row of
+ *
+ * seconds       time since start
+ * ops           pget, lpushback, ipop, preturn and trimmed nodes so far
+ * ops_per_s     throughput since the previous sample
+ * walk_ns       time per node of a traversal of the list
+ * samepage_pct  links within the same page, the locality behind walk_ns
+ * live, pooled  nodes in the list and in the pool
+ * rss_kib       resident set size
+ * heap_kib      bytes malloc holds from the system (main arena and mmapped chunks)
+ * frag_pct      free bytes inside the main arena in percent of its size
+ *
+ * bench_soak [-n ops] [-d seconds] [-i seconds] [-l live] [-o series.csv]
+ */
+
+#define LIVE     (256*1024)
+#define OPS      (1000ull*1000*1000)
+#define INTERVAL 10.0
+
+typedef struct soaknode {
+	SLL_LINK(soaknode);
+	uint64_t payload[5];
+} soaknode;
+
+SLL_DECLS(soak, soaknode, soaklist);
+SLL_ITER_DECLS(soak, soaknode, soaklist, soakiter);
+SLL_POOL_DECLS(soak, soaknode, soaklist, soakpool);
+
+SLL_DEFS(soak, soaknode, soaklist, free);
+SLL_ITER_DEFS(soak, soaknode, soaklist, soakiter);
+SLL_POOL_DEFS(soak, soaknode, soaklist, soakpool);
+
+static uint64_t rng = 88172645463325252u;
+static uint64_t xorshift(void) {
+	rng ^= rng << 13;
+	rng ^= rng >> 7;
+	rng ^= rng << 17;
+	return rng;
+}
+
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long rsskib(void) {
+	long pages = 0, resident = 0;
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (f == NULL) { return -1; }
+	if (fscanf(f, "%ld %ld", &pages, &resident) != 2) { resident = -1; }
+	fclose(f);
+	return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void sample(FILE *out, double elapsed, uint64_t ops, double rate, soaklist *list, soakpool *pool) {
+	uint64_t sum = 0;
+	size_t samepage = 0;
+	double t0 = now();
+	for (soaknode *node = list->first; node != NULL; node = SLL_NEXT(node)) {
+		sum += node->payload[0];
+	}
+	double walk = now() - t0;
+	for (soaknode *node = list->first; node != NULL && SLL_NEXT(node) != NULL; node = SLL_NEXT(node)) {
+		if (((uintptr_t)node >> 12) == ((uintptr_t)SLL_NEXT(node) >> 12)) {
+			++samepage;
+		}
+	}
+	struct mallinfo2 mi = mallinfo2();
+	size_t n = list->n > 0 ? list->n : 1;
+	fprintf(out, "%.1f,%llu,%.0f,%.2f,%.1f,%zu,%zu,%ld,%zu,%.1f\n",
+	        elapsed, (unsigned long long)ops, rate, walk * 1e9 / n, 100.0 * samepage / n,
+	        list->n, soak_lsize(pool), rsskib(), (mi.arena + mi.hblkhd) / 1024,
+	        mi.arena > 0 ? 100.0 * mi.fordblks / mi.arena : 0.0);
+	fflush(out);
+	/* keeps the traversal from being optimized away */
+	if (sum == UINT64_MAX) { fputc('\n', stderr); }
+}
+
+static void usage(const char *argv0) {
+	fprintf(stderr, "usage: %s [-n ops] [-d seconds] [-i seconds] [-l live] [-o series.csv]\n", argv0);
+	exit(2);
+}
+
+int main(int argc, char **argv) {
+	uint64_t budget = OPS;
+	double duration = 0, interval = INTERVAL;
+	size_t live = LIVE;
+	FILE *out = stdout;
+	int opt;
+	while ((opt = getopt(argc, argv, "n:d:i:l:o:")) != -1) {
+		switch (opt) {
+		case 'n': budget = strtoull(optarg, NULL, 10); break;
+		case 'd': duration = strtod(optarg, NULL); break;
+		case 'i': interval = strtod(optarg, NULL); break;
+		case 'l': live = strtoul(optarg, NULL, 10); break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if (out == NULL) { perror(optarg); return 2; }
+			break;
+		default: usage(argv[0]);
+		}
+	}
+	if (interval <= 0 || live < 2) { usage(argv[0]); }
+
+	soaklist list;
+	soakpool pool;
+	soak_lclear(&list);
+	soak_pclear(&pool);
+	size_t target = live;
+	uint64_t ops = 0, last_ops = 0;
+	double start = now(), last = start;
+	fprintf(out, "seconds,ops,ops_per_s,walk_ns,samepage_pct,live,pooled,rss_kib,heap_kib,frag_pct\n");
+	sample(out, 0, 0, 0, &list, &pool);
+	while (ops < budget && (duration <= 0 || now() - start < duration)) {
+		/* random walk of the live size between half and one and a half times live */
+		size_t step = live / 16 + 1;
+		if (xorshift() & 1) { target = target + step <= live * 3 / 2 ? target + step : target; }
+		else { target = target >= live / 2 + step ? target - step : target; }
+
+		for (soakiter iter=SLL_ISTART(&list); !soak_iisend(&iter); soak_inext(&iter)) {
+			if ((xorshift() & 7) == 0) {
+				soak_preturn(&pool, soak_ipop(&iter));
+				ops += 2;
+			}
+		}
+		while (list.n < target) {
+			soaknode *node = soak_pget(&pool);
+			if (node == NULL) { perror("pget"); return 1; }
+			node->payload[0] = ops;
+			soak_lpushback(&list, node);
+			ops += 2;
+		}
+		if ((xorshift() & 15) == 0) {
+			ops += soak_ptrim(&pool, live / 8);
+		}
+
+		double t = now();
+		if (t - last >= interval) {
+			sample(out, t - start, ops, (ops - last_ops) / (t - last), &list, &pool);
+			last = t;
+			last_ops = ops;
+		}
+	}
+	double t = now();
+	sample(out, t - start, ops, (ops - last_ops) / (t - last > 0 ? t - last : 1), &list, &pool);
+
+	soak_lfree(&list);
+	soak_pfree(&pool);
+	if (out != stdout) { fclose(out); }
+	return 0;
+}
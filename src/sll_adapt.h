@@ -0,0 +1,211 @@
+#pragma once
+
+/*
+ * contention adaptive multi producer queue on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_ADAPT_DECLS(mysll, mynode, mylist, myqueue, myproducer);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_ADAPT_DEFS(mysll, mynode, mylist, myqueue, myproducer);
+ *
+ * where source stuff is appropriate, gives you a thread safe FIFO queue type myqueue and a producer
+ * handle type myproducer, one per producing thread. The queue runs in one of two modes and switches
+ * between them on its own as the load changes:
+ *
+ * direct  producers and consumers lpushback and lpopfront on the shared list under a spin lock. This
+ *         is the cheapest there is as long as threads rarely meet, and every lock taken counts whether
+ *         the first try failed. When more than 1 in SLL_ADAPT_HIGH of the last SLL_ADAPT_WINDOW lock
+ *         acquisitions had to spin, the queue goes staged.
+ * staged  producers lpushback onto a staging list of their own, guarded by a lock only the consumer
+ *         splicing it ever competes for, and a consumer finding the shared list empty splices all
+ *         staging lists onto it in one go. Every splice counts how many producers had staged nodes,
+ *         and when SLL_ADAPT_WINDOW / 16 splices in a row averaged one producer or less, the queue
+ *         goes direct again.
+ *
+ * Nodes from the same producer come out in the order they were pushed, in either mode and across
+ * switches: a producer keeps staging while its staging list is not empty.
+ *
+ * void    mysll_aqinit(myqueue *queue)                   // initializes an empty queue in direct mode
+ * void    mysll_aqattach(myqueue *queue, myproducer *producer)
+ *                                                        // registers a producer handle
+ * void    mysll_aqdetach(myqueue *queue, myproducer *producer)
+ *                                                        // unregisters a producer handle, its staged nodes stay queued
+ * void    mysll_aqpush(myqueue *queue, myproducer *producer, mynode *node)
+ *                                                        // appends node
+ * mynode *mysll_aqpop(myqueue *queue)                    // removes and returns the first node (or NULL), never blocks
+ * bool    mysll_aqstaged(const myqueue *queue)           // returns true if the queue is in staged mode
+ * size_t  mysll_aqswitches(const myqueue *queue)         // returns the number of mode switches so far
+ *
+ */
+
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "sll_meta.h"
+
+#ifndef SLL_ADAPT_WINDOW
+#define SLL_ADAPT_WINDOW 1024
+#endif
+
+#ifndef SLL_ADAPT_HIGH
+#define SLL_ADAPT_HIGH 16
+#endif
+
+// returns true if the lock was contended, i.e. not free at the first try
+static inline bool sll_adapt_lock(atomic_bool *lock) {
+	if (!atomic_exchange_explicit(lock, true, memory_order_acquire)) { return false; }
+	unsigned spins = 0;
+	do {
+		while (atomic_load_explicit(lock, memory_order_relaxed)) {
+			/* the holder may be preempted, so do not burn a whole slice on it */
+			if (++spins % 64 == 0) { sched_yield(); }
+		}
+	} while (atomic_exchange_explicit(lock, true, memory_order_acquire));
+	return true;
+}
+
+static inline void sll_adapt_unlock(atomic_bool *lock) {
+	atomic_store_explicit(lock, false, memory_order_release);
+}
+
+// header declarations
+#define SLL_ADAPT_DECLS(function_prefix, node_type, list_type, queue_type, producer_type) \
+	typedef struct producer_type { /*{{{*/ \
+		SLL_LINK(producer_type); \
+		atomic_bool lock; \
+		list_type staged; \
+	} producer_type; /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, aq), producer_type, CONCAT(producer_type, list)); \
+	typedef struct { /*{{{*/ \
+		atomic_bool lock; \
+		list_type list; \
+		CONCAT(producer_type, list) producers; \
+		atomic_bool staged; \
+		atomic_size_t ops; \
+		atomic_size_t contended; \
+		size_t splices; \
+		size_t stagers; \
+		atomic_size_t switches; \
+	} queue_type; /*}}}*/ \
+	void       CONCAT(function_prefix, aqinit)    (queue_type *queue); \
+	void       CONCAT(function_prefix, aqattach)  (queue_type *queue, producer_type *producer); \
+	void       CONCAT(function_prefix, aqdetach)  (queue_type *queue, producer_type *producer); \
+	void       CONCAT(function_prefix, aqpush)    (queue_type *queue, producer_type *producer, node_type *node); \
+	node_type *CONCAT(function_prefix, aqpop)     (queue_type *queue); \
+	bool       CONCAT(function_prefix, aqstaged)  (const queue_type *queue); \
+	size_t     CONCAT(function_prefix, aqswitches)(const queue_type *queue)
+
+// definitions
+
+#define SLL_ADAPT_DEFS(function_prefix, node_type, list_type, queue_type, producer_type) \
+	/* producer handles are owned by their threads, so freeing the registry must not free them */ \
+	SLL_DEFS(CONCAT(function_prefix, aq), producer_type, CONCAT(producer_type, list), (void)) \
+	static void CONCAT(function_prefix, aqlock)(queue_type *queue) { /*{{{*/ \
+		bool contended = sll_adapt_lock(&queue->lock); \
+		if (atomic_load_explicit(&queue->staged, memory_order_relaxed)) { return; } \
+		if (contended) { atomic_fetch_add_explicit(&queue->contended, 1, memory_order_relaxed); } \
+		if (atomic_fetch_add_explicit(&queue->ops, 1, memory_order_relaxed) + 1 < SLL_ADAPT_WINDOW) { return; } \
+		/* end of a window, we hold the lock so nobody else evaluates it */ \
+		if (atomic_load_explicit(&queue->contended, memory_order_relaxed) * SLL_ADAPT_HIGH > SLL_ADAPT_WINDOW) { \
+			queue->splices = 0; \
+			queue->stagers = 0; \
+			atomic_store_explicit(&queue->staged, true, memory_order_relaxed); \
+			atomic_fetch_add_explicit(&queue->switches, 1, memory_order_relaxed); \
+		} \
+		atomic_store_explicit(&queue->ops, 0, memory_order_relaxed); \
+		atomic_store_explicit(&queue->contended, 0, memory_order_relaxed); \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, aqgather)(queue_type *queue) { /*{{{*/ \
+		/* called with the queue locked, which is always taken before a producer lock */ \
+		size_t stagers = 0; \
+		for (producer_type *producer = queue->producers.first; producer != NULL; producer = SLL_NEXT(producer)) { \
+			sll_adapt_lock(&producer->lock); \
+			if (producer->staged.n > 0) { \
+				CONCAT(function_prefix, lsplice)(&queue->list, &producer->staged); \
+				++stagers; \
+			} \
+			sll_adapt_unlock(&producer->lock); \
+		} \
+		if (!atomic_load_explicit(&queue->staged, memory_order_relaxed)) { return; } \
+		queue->stagers += stagers; \
+		if (++queue->splices < SLL_ADAPT_WINDOW / 16) { return; } \
+		if (queue->stagers <= queue->splices) { \
+			atomic_store_explicit(&queue->ops, 0, memory_order_relaxed); \
+			atomic_store_explicit(&queue->contended, 0, memory_order_relaxed); \
+			atomic_store_explicit(&queue->staged, false, memory_order_relaxed); \
+			atomic_fetch_add_explicit(&queue->switches, 1, memory_order_relaxed); \
+		} \
+		queue->splices = 0; \
+		queue->stagers = 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, aqinit)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		atomic_init(&queue->lock, false); \
+		CONCAT(function_prefix, lclear)(&queue->list); \
+		CONCAT(CONCAT(function_prefix, aq), lclear)(&queue->producers); \
+		atomic_init(&queue->staged, false); \
+		atomic_init(&queue->ops, 0); \
+		atomic_init(&queue->contended, 0); \
+		queue->splices = 0; \
+		queue->stagers = 0; \
+		atomic_init(&queue->switches, 0); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, aqattach)(queue_type *queue, producer_type *producer) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(producer != NULL); \
+		atomic_init(&producer->lock, false); \
+		CONCAT(function_prefix, lclear)(&producer->staged); \
+		sll_adapt_lock(&queue->lock); \
+		CONCAT(CONCAT(function_prefix, aq), lpushback)(&queue->producers, producer); \
+		sll_adapt_unlock(&queue->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, aqdetach)(queue_type *queue, producer_type *producer) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(producer != NULL); \
+		CONCAT(producer_type, list) kept; \
+		producer_type *other; \
+		CONCAT(CONCAT(function_prefix, aq), lclear)(&kept); \
+		sll_adapt_lock(&queue->lock); \
+		while ((other = CONCAT(CONCAT(function_prefix, aq), lpopfront)(&queue->producers)) != NULL) { \
+			if (other != producer) { CONCAT(CONCAT(function_prefix, aq), lpushback)(&kept, other); } \
+		} \
+		queue->producers = kept; \
+		CONCAT(function_prefix, lsplice)(&queue->list, &producer->staged); \
+		sll_adapt_unlock(&queue->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, aqpush)(queue_type *queue, producer_type *producer, node_type *node) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(producer != NULL); \
+		assert(node != NULL); \
+		sll_adapt_lock(&producer->lock); \
+		if (atomic_load_explicit(&queue->staged, memory_order_relaxed) || producer->staged.n > 0) { \
+			CONCAT(function_prefix, lpushback)(&producer->staged, node); \
+			sll_adapt_unlock(&producer->lock); \
+			return; \
+		} \
+		sll_adapt_unlock(&producer->lock); \
+		/* nothing of ours is staged, and only we could stage more */ \
+		CONCAT(function_prefix, aqlock)(queue); \
+		CONCAT(function_prefix, lpushback)(&queue->list, node); \
+		sll_adapt_unlock(&queue->lock); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, aqpop)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		CONCAT(function_prefix, aqlock)(queue); \
+		if (queue->list.n == 0) { CONCAT(function_prefix, aqgather)(queue); } \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&queue->list); \
+		sll_adapt_unlock(&queue->lock); \
+		return node; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, aqstaged)(const queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return atomic_load_explicit(&queue->staged, memory_order_relaxed); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, aqswitches)(const queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return atomic_load_explicit(&queue->switches, memory_order_relaxed); \
+	} /*}}}*/
@@ -0,0 +1,177 @@
+#pragma once
+
+/*
+ * size and time triggered batch accumulator on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_BATCH_DECLS(mysll, mynode, mylist, mybatch);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_BATCH_DEFS(mysll, mynode, mylist, mybatch, nodesize);
+ *
+ * where source stuff is appropriate, gives you an accumulator type mybatch that collects nodes and
+ * hands them over as one list, by splice, when it holds max_nodes nodes, max_bytes bytes (as
+ * reported by size_t nodesize(const mynode *node)) or its first node is max_usec microseconds old,
+ * whichever comes first. A limit of 0 disables that trigger.
+ *
+ * The flush callback gets the batch as a list and takes over its nodes; the batch list is empty
+ * again once the callback returns, whatever the callback did with it. To flush into a queue instead,
+ * pass mysll_bsplicesink as the callback and the queue (a mylist *) as its argument.
+ *
+ * The age trigger is checked on every push, and otherwise has to be driven by the caller: either
+ * call mysll_btick from the event loop, using mysll_bdeadline to compute the poll timeout, or
+ * get a timerfd from mysll_btimerfd, which is armed while the batch holds nodes, and call
+ * mysll_btick when it becomes readable.
+ *
+ * void     mysll_binit(mybatch *batch, size_t max_nodes, size_t max_bytes, uint64_t max_usec,
+ *                      void (*flush)(mylist *nodes, void *arg), void *arg)
+ *                                                      // initializes an empty accumulator
+ * void     mysll_bdestroy(mybatch *batch)              // closes the timerfd, if any, nodes still held are left alone
+ * size_t   mysll_bsize(const mybatch *batch)           // returns the number of nodes held
+ * size_t   mysll_bbytes(const mybatch *batch)          // returns the number of bytes held
+ * bool     mysll_bpush(mybatch *batch, mynode *node)   // appends a node, returns true if it caused a flush
+ * bool     mysll_btick(mybatch *batch)                 // flushes if the first node is old enough, returns true if it did
+ * void     mysll_bflush(mybatch *batch)                // flushes whatever is held, if anything
+ * uint64_t mysll_bdeadline(const mybatch *batch)       // returns the CLOCK_MONOTONIC time in microseconds when the age
+ *                                                      // trigger fires, or UINT64_MAX if it can not
+ * int      mysll_btimerfd(mybatch *batch)              // returns a timerfd tracking the age trigger (or -1 on failure)
+ * void     mysll_bsplicesink(mylist *nodes, void *arg) // flush callback splicing the batch onto the mylist arg
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "sll_meta.h"
+
+static inline uint64_t sll_batch_now(void) { /*{{{*/
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+} /*}}}*/
+
+// header declarations
+#define SLL_BATCH_DECLS(function_prefix, node_type, list_type, batch_type) \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		size_t bytes; \
+		uint64_t first; \
+		size_t max_nodes; \
+		size_t max_bytes; \
+		uint64_t max_usec; \
+		void (*flush)(list_type *nodes, void *arg); \
+		void *arg; \
+		int timerfd; \
+	} batch_type; /*}}}*/ \
+	void     CONCAT(function_prefix, binit)     (batch_type *batch, size_t max_nodes, size_t max_bytes, uint64_t max_usec, \
+	                                             void (*flush)(list_type *nodes, void *arg), void *arg); \
+	void     CONCAT(function_prefix, bdestroy)  (batch_type *batch); \
+	size_t   CONCAT(function_prefix, bsize)     (const batch_type *batch); \
+	size_t   CONCAT(function_prefix, bbytes)    (const batch_type *batch); \
+	bool     CONCAT(function_prefix, bpush)     (batch_type *batch, node_type *node); \
+	bool     CONCAT(function_prefix, btick)     (batch_type *batch); \
+	void     CONCAT(function_prefix, bflush)    (batch_type *batch); \
+	uint64_t CONCAT(function_prefix, bdeadline) (const batch_type *batch); \
+	int      CONCAT(function_prefix, btimerfd)  (batch_type *batch); \
+	void     CONCAT(function_prefix, bsplicesink)(list_type *nodes, void *arg)
+
+// definitions
+
+#define SLL_BATCH_DEFS(function_prefix, node_type, list_type, batch_type, node_size_func) \
+	static void CONCAT(function_prefix, barm)(batch_type *batch, uint64_t usec) { /*{{{*/ \
+		if (batch->timerfd < 0) { return; } \
+		struct itimerspec its = { \
+			.it_interval = { 0, 0 }, \
+			.it_value = { .tv_sec = usec / 1000000u, .tv_nsec = (usec % 1000000u) * 1000u } \
+		}; \
+		timerfd_settime(batch->timerfd, usec != 0 ? TFD_TIMER_ABSTIME : 0, &its, NULL); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, binit)(batch_type *batch, size_t max_nodes, size_t max_bytes, uint64_t max_usec, \
+	                                    void (*flush)(list_type *nodes, void *arg), void *arg) { /*{{{*/ \
+		assert(batch != NULL); \
+		assert(flush != NULL); \
+		CONCAT(function_prefix, lclear)(&batch->list); \
+		batch->bytes = 0; \
+		batch->first = 0; \
+		batch->max_nodes = max_nodes; \
+		batch->max_bytes = max_bytes; \
+		batch->max_usec = max_usec; \
+		batch->flush = flush; \
+		batch->arg = arg; \
+		batch->timerfd = -1; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bdestroy)(batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		if (batch->timerfd >= 0) { close(batch->timerfd); } \
+		batch->timerfd = -1; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bsize)(const batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		return batch->list.n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bbytes)(const batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		return batch->bytes; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bflush)(batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		if (batch->list.n == 0) { return; } \
+		list_type nodes = batch->list; \
+		CONCAT(function_prefix, lclear)(&batch->list); \
+		batch->bytes = 0; \
+		CONCAT(function_prefix, barm)(batch, 0); \
+		/* the callback may push again, so the batch is reset before it runs */ \
+		batch->flush(&nodes, batch->arg); \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, bpush)(batch_type *batch, node_type *node) { /*{{{*/ \
+		assert(batch != NULL); \
+		assert(node != NULL); \
+		uint64_t now = batch->max_usec != 0 ? sll_batch_now() : 0; \
+		if (batch->list.n == 0) { \
+			batch->first = now; \
+			if (batch->max_usec != 0) { CONCAT(function_prefix, barm)(batch, now + batch->max_usec); } \
+		} \
+		CONCAT(function_prefix, lpushback)(&batch->list, node); \
+		batch->bytes += node_size_func(node); \
+		if ((batch->max_nodes != 0 && batch->list.n >= batch->max_nodes) \
+		 || (batch->max_bytes != 0 && batch->bytes >= batch->max_bytes) \
+		 || (batch->max_usec != 0 && now - batch->first >= batch->max_usec)) { \
+			CONCAT(function_prefix, bflush)(batch); \
+			return true; \
+		} \
+		return false; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, btick)(batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		if (batch->timerfd >= 0) { \
+			uint64_t expirations; \
+			ssize_t r = read(batch->timerfd, &expirations, sizeof(expirations)); /* drains the expiration, if any */ \
+			(void)r; \
+		} \
+		if (sll_batch_now() < CONCAT(function_prefix, bdeadline)(batch)) { return false; } \
+		CONCAT(function_prefix, bflush)(batch); \
+		return true; \
+	} /*}}}*/ \
+	uint64_t CONCAT(function_prefix, bdeadline)(const batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		if (batch->list.n == 0 || batch->max_usec == 0) { return UINT64_MAX; } \
+		return batch->first + batch->max_usec; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, btimerfd)(batch_type *batch) { /*{{{*/ \
+		assert(batch != NULL); \
+		if (batch->timerfd >= 0) { return batch->timerfd; } \
+		batch->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC); \
+		if (batch->timerfd >= 0 && batch->list.n > 0 && batch->max_usec != 0) { \
+			CONCAT(function_prefix, barm)(batch, batch->first + batch->max_usec); \
+		} \
+		return batch->timerfd; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bsplicesink)(list_type *nodes, void *arg) { /*{{{*/ \
+		assert(arg != NULL); \
+		CONCAT(function_prefix, lsplice)((list_type *)arg, nodes); \
+	} /*}}}*/
@@ -0,0 +1,236 @@
+#pragma once
+
+/*
+ * single producer, multiple consumer broadcast list on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_BCAST_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_POOL_DECLS(mysll, mynode, mylist, mypool);
+ * SLL_BCAST_DECLS(mysll, mynode, mylist, mypool, mybcast, myconsumer);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_POOL_DEFS(mysll, mynode, mylist, mypool);
+ * SLL_BCAST_DEFS(mysll, mynode, mylist, mypool, mybcast, myconsumer);
+ *
+ * where source stuff is appropriate, you get a broadcast type mybcast, an append only list that one
+ * producer thread pushes to, and a consumer type myconsumer, a cursor into that list. Every consumer
+ * sees every node pushed after it joined, in order, without copying: a node is shared by all
+ * consumers and stays valid for a consumer until its next call to bcnext or bcwait. Nodes are
+ * numbered as they are pushed and every consumer publishes the number of the node it is at, so the
+ * producer can return the nodes that the slowest consumer has passed to the pool in one sweep.
+ * Pushing and consuming take no locks; the lock is only taken by consumers that block, and when
+ * consumers join, leave, or nodes are reclaimed.
+ *
+ * bcpush, bcreclaim, bcclose and bcdestroy are for the producer thread, the pool is only ever touched
+ * by it. A consumer is used by one thread at a time.
+ *
+ * bool    mysll_bcinit(mybcast *bcast)              // initializes an empty broadcast list, false on failure
+ * void    mysll_bcdestroy(mybcast *bcast, mypool *pool)
+ *                                                   // returns all nodes still held to pool and releases the list,
+ *                                                   // consumers must have left
+ * void    mysll_bcpush(mybcast *bcast, mynode *node)
+ *                                                   // appends node for all consumers
+ * size_t  mysll_bcreclaim(mybcast *bcast, mypool *pool)
+ *                                                   // returns the nodes every consumer has passed to pool, returns how many
+ * void    mysll_bcclose(mybcast *bcast)             // marks the end of the stream, waking up consumers blocked in bcwait
+ * size_t  mysll_bcsize(const mybcast *bcast)        // returns the number of nodes held, i.e. not reclaimed yet
+ * void    mysll_bcjoin(mybcast *bcast, myconsumer *consumer)
+ *                                                   // starts a consumer after the newest node held, which is the
+ *                                                   // newest node pushed unless the slowest consumer was behind
+ * void    mysll_bcleave(mybcast *bcast, myconsumer *consumer)
+ *                                                   // stops a consumer, so that it no longer holds nodes back
+ * mynode *mysll_bcnext(myconsumer *consumer)        // returns the next node for the consumer (or NULL if there is none yet)
+ * mynode *mysll_bcwait(mybcast *bcast, myconsumer *consumer)
+ *                                                   // like bcnext, but blocks until there is a node, returns NULL
+ *                                                   // once the list is closed and the consumer has seen everything
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+// in-type data addition
+#define SLL_BCAST_LINK uint64_t sll_bcast_seq
+
+// header declarations
+#define SLL_BCAST_DECLS(function_prefix, node_type, list_type, pool_type, bcast_type, consumer_type) \
+	typedef struct consumer_type { /*{{{*/ \
+		SLL_LINK(consumer_type); \
+		node_type *pos; \
+		atomic_uint_fast64_t seq; \
+	} consumer_type; /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, bc), consumer_type, CONCAT(consumer_type, list)); \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		node_type stub; \
+		uint64_t seq; \
+		CONCAT(consumer_type, list) consumers; \
+		atomic_bool closed; \
+		atomic_size_t waiting; \
+		pthread_mutex_t lock; \
+		pthread_cond_t ready; \
+	} bcast_type; /*}}}*/ \
+	bool       CONCAT(function_prefix, bcinit)   (bcast_type *bcast); \
+	void       CONCAT(function_prefix, bcdestroy)(bcast_type *bcast, pool_type *pool); \
+	void       CONCAT(function_prefix, bcpush)   (bcast_type *bcast, node_type *node); \
+	size_t     CONCAT(function_prefix, bcreclaim)(bcast_type *bcast, pool_type *pool); \
+	void       CONCAT(function_prefix, bcclose)  (bcast_type *bcast); \
+	size_t     CONCAT(function_prefix, bcsize)   (const bcast_type *bcast); \
+	void       CONCAT(function_prefix, bcjoin)   (bcast_type *bcast, consumer_type *consumer); \
+	void       CONCAT(function_prefix, bcleave)  (bcast_type *bcast, consumer_type *consumer); \
+	node_type *CONCAT(function_prefix, bcnext)   (consumer_type *consumer); \
+	node_type *CONCAT(function_prefix, bcwait)   (bcast_type *bcast, consumer_type *consumer)
+
+// definitions
+
+/*
+ * The list always holds at least one node, initially the embedded stub, so that every consumer has
+ * a node to stand on and read the next link of. A consumer at node seq keeps that node alive, and
+ * the nodes before the one the slowest consumer is at are free to go.
+ */
+#define SLL_BCAST_DEFS(function_prefix, node_type, list_type, pool_type, bcast_type, consumer_type) \
+	/* consumers are owned by their threads, so freeing the consumer list must not free them */ \
+	SLL_DEFS(CONCAT(function_prefix, bc), consumer_type, CONCAT(consumer_type, list), (void)) \
+	bool CONCAT(function_prefix, bcinit)(bcast_type *bcast) { /*{{{*/ \
+		assert(bcast != NULL); \
+		if (pthread_mutex_init(&bcast->lock, NULL) != 0) { return false; } \
+		if (pthread_cond_init(&bcast->ready, NULL) != 0) { \
+			pthread_mutex_destroy(&bcast->lock); \
+			return false; \
+		} \
+		CONCAT(function_prefix, lclear)(&bcast->list); \
+		bcast->stub.sll_bcast_seq = 0; \
+		CONCAT(function_prefix, lpushback)(&bcast->list, &bcast->stub); \
+		bcast->seq = 0; \
+		CONCAT(CONCAT(function_prefix, bc), lclear)(&bcast->consumers); \
+		atomic_init(&bcast->closed, false); \
+		atomic_init(&bcast->waiting, 0); \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bcdestroy)(bcast_type *bcast, pool_type *pool) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(pool != NULL); \
+		assert(bcast->consumers.n == 0); \
+		node_type *node; \
+		while ((node = CONCAT(function_prefix, lpopfront)(&bcast->list)) != NULL) { \
+			if (node != &bcast->stub) { CONCAT(function_prefix, preturn)(pool, node); } \
+		} \
+		pthread_cond_destroy(&bcast->ready); \
+		pthread_mutex_destroy(&bcast->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bcpush)(bcast_type *bcast, node_type *node) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(node != NULL); \
+		/* not lpushback, consumers may be reading the link of the last node while it is set */ \
+		node->sll_bcast_seq = ++bcast->seq; \
+		SLL_LNCLEAR(node); \
+		/* sequentially consistent like the waiting count, so a consumer going to sleep cannot miss it */ \
+		/* only the producer writes links, so the tag bits of last cannot change under us */ \
+		node_type *last = bcast->list.last; \
+		__atomic_store_n(&last->sll_link_next, (node_type *)((uintptr_t)node | ((uintptr_t)last->sll_link_next & SLL_TAG_MASK)), __ATOMIC_SEQ_CST); \
+		bcast->list.last = node; \
+		++bcast->list.n; \
+		if (atomic_load(&bcast->waiting) > 0) { \
+			pthread_mutex_lock(&bcast->lock); \
+			pthread_cond_broadcast(&bcast->ready); \
+			pthread_mutex_unlock(&bcast->lock); \
+		} \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bcreclaim)(bcast_type *bcast, pool_type *pool) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(pool != NULL); \
+		size_t reclaimed = 0; \
+		pthread_mutex_lock(&bcast->lock); \
+		/* without consumers only the newest node is kept, for the next one to join at */ \
+		uint64_t slowest = bcast->seq; \
+		for (consumer_type *consumer = bcast->consumers.first; consumer != NULL; consumer = SLL_NEXT(consumer)) { \
+			uint64_t seq = atomic_load_explicit(&consumer->seq, memory_order_acquire); \
+			if (seq < slowest) { slowest = seq; } \
+		} \
+		while (bcast->list.first->sll_bcast_seq < slowest) { \
+			node_type *node = CONCAT(function_prefix, lpopfront)(&bcast->list); \
+			if (node != &bcast->stub) { \
+				CONCAT(function_prefix, preturn)(pool, node); \
+				++reclaimed; \
+			} \
+		} \
+		pthread_mutex_unlock(&bcast->lock); \
+		return reclaimed; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bcclose)(bcast_type *bcast) { /*{{{*/ \
+		assert(bcast != NULL); \
+		pthread_mutex_lock(&bcast->lock); \
+		atomic_store(&bcast->closed, true); \
+		pthread_cond_broadcast(&bcast->ready); \
+		pthread_mutex_unlock(&bcast->lock); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bcsize)(const bcast_type *bcast) { /*{{{*/ \
+		assert(bcast != NULL); \
+		return bcast->list.n - (bcast->list.first == &bcast->stub ? 1 : 0); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bcjoin)(bcast_type *bcast, consumer_type *consumer) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(consumer != NULL); \
+		pthread_mutex_lock(&bcast->lock); \
+		/* the oldest node held is the only one known to stay until this consumer is registered */ \
+		node_type *node = bcast->list.first; \
+		consumer->pos = node; \
+		atomic_init(&consumer->seq, node->sll_bcast_seq); \
+		CONCAT(CONCAT(function_prefix, bc), lpushback)(&bcast->consumers, consumer); \
+		pthread_mutex_unlock(&bcast->lock); \
+		/* skip to the newest node, publishing progress as usual */ \
+		while (CONCAT(function_prefix, bcnext)(consumer) != NULL) {} \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bcleave)(bcast_type *bcast, consumer_type *consumer) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(consumer != NULL); \
+		CONCAT(consumer_type, list) kept; \
+		consumer_type *other; \
+		CONCAT(CONCAT(function_prefix, bc), lclear)(&kept); \
+		pthread_mutex_lock(&bcast->lock); \
+		while ((other = CONCAT(CONCAT(function_prefix, bc), lpopfront)(&bcast->consumers)) != NULL) { \
+			if (other != consumer) { CONCAT(CONCAT(function_prefix, bc), lpushback)(&kept, other); } \
+		} \
+		bcast->consumers = kept; \
+		pthread_mutex_unlock(&bcast->lock); \
+		consumer->pos = NULL; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, bcnext)(consumer_type *consumer) { /*{{{*/ \
+		assert(consumer != NULL); \
+		assert(consumer->pos != NULL); \
+		node_type *node = (node_type *)((uintptr_t)__atomic_load_n(&consumer->pos->sll_link_next, __ATOMIC_SEQ_CST) & ~SLL_TAG_MASK); \
+		if (node == NULL) { return NULL; } \
+		consumer->pos = node; \
+		atomic_store_explicit(&consumer->seq, node->sll_bcast_seq, memory_order_release); \
+		return node; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, bcwait)(bcast_type *bcast, consumer_type *consumer) { /*{{{*/ \
+		assert(bcast != NULL); \
+		assert(consumer != NULL); \
+		node_type *node = CONCAT(function_prefix, bcnext)(consumer); \
+		if (node != NULL) { return node; } \
+		pthread_mutex_lock(&bcast->lock); \
+		atomic_fetch_add(&bcast->waiting, 1); \
+		/* the producer checks waiting after publishing, so either it sees us or we see its node */ \
+		while ((node = CONCAT(function_prefix, bcnext)(consumer)) == NULL && !atomic_load(&bcast->closed)) { \
+			pthread_cond_wait(&bcast->ready, &bcast->lock); \
+		} \
+		atomic_fetch_sub(&bcast->waiting, 1); \
+		pthread_mutex_unlock(&bcast->lock); \
+		return node; \
+	} /*}}}*/
@@ -0,0 +1,125 @@
+#pragma once
+
+/*
+ * bump-then-freelist node pool over lazily touched reservations, as an alternative to the pool in sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_BUMP_DECLS(mysll, mynode, mylist, mybumppool);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_BUMP_DEFS(mysll, mynode, mylist, mybumppool);
+ *
+ * where source stuff is appropriate, gives you a pool type mybumppool that reserves room for many
+ * nodes at a time with an anonymous mapping but never walks the reservation to link it up. A get
+ * takes the first node of the free list of returned nodes, and only if there is none bumps a
+ * pointer into the current reservation, so the kernel faults in the pages of a reservation one by
+ * one as nodes are actually handed out, and a generous reserve for bursts that never come costs
+ * address space but no memory. When a reservation is used up, the next one is mapped.
+ *
+ * Nodes fresh from a reservation are zeroed, recycled nodes are handed out as they were returned.
+ * Nodes from a bump pool must only be returned to the pool they came from and never free'd
+ * directly, so lists of them must not be released with lfree unless node_free_func is a no-op.
+ *
+ * void    mysll_bpinit(mybumppool *pool, size_t reserve)  // initializes an empty pool reserving room for reserve
+ *                                                         // nodes at a time, nothing is mapped before the first get
+ * mynode *mysll_bpget(mybumppool *pool)                   // returns a node from the pool (or NULL if out of memory)
+ * void    mysll_bpreturn(mybumppool *pool, mynode *node)  // puts the node back in the pool
+ * size_t  mysll_bpreserved(const mybumppool *pool)        // returns the number of nodes room is reserved for
+ * size_t  mysll_bptouched(const mybumppool *pool)         // returns the number of nodes ever handed out from the
+ *                                                         // reservations, which bounds the memory actually used
+ * void    mysll_bpfree(mybumppool *pool)                  // unmaps all reservations, also with nodes handed out
+ *
+ */
+
+#include <stdint.h>
+#include <sys/mman.h>
+#include "sll_meta.h"
+
+// header declarations
+#define SLL_BUMP_DECLS(function_prefix, node_type, list_type, pool_type) \
+	typedef struct CONCAT(pool_type, chunk) { /*{{{*/ \
+		SLL_LINK(CONCAT(pool_type, chunk)); \
+		size_t bytes; \
+		node_type nodes[]; \
+	} CONCAT(pool_type, chunk); /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, bp), CONCAT(pool_type, chunk), CONCAT(pool_type, chunklist)); \
+	typedef struct { /*{{{*/ \
+		list_type free; \
+		CONCAT(pool_type, chunklist) chunks; \
+		node_type *next; \
+		node_type *end; \
+		size_t reserve; \
+		size_t touched; \
+	} pool_type; /*}}}*/ \
+	void       CONCAT(function_prefix, bpinit)    (pool_type *pool, size_t reserve); \
+	node_type *CONCAT(function_prefix, bpget)     (pool_type *pool); \
+	void       CONCAT(function_prefix, bpreturn)  (pool_type *pool, node_type *node); \
+	size_t     CONCAT(function_prefix, bpreserved)(const pool_type *pool); \
+	size_t     CONCAT(function_prefix, bptouched) (const pool_type *pool); \
+	void       CONCAT(function_prefix, bpfree)    (pool_type *pool)
+
+// definitions
+
+#define SLL_BUMP_DEFS(function_prefix, node_type, list_type, pool_type) \
+	/* chunks are unmapped by bpfree, never handed to a free function */ \
+	SLL_DEFS(CONCAT(function_prefix, bp), CONCAT(pool_type, chunk), CONCAT(pool_type, chunklist), (void)) \
+	static bool CONCAT(function_prefix, bpchunk)(pool_type *pool) { /*{{{*/ \
+		size_t bytes = sizeof(CONCAT(pool_type, chunk)) + pool->reserve * sizeof(node_type); \
+		/* mappings come zeroed and untouched, which is the whole point of not linking them */ \
+		void *mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0); \
+		if (mem == MAP_FAILED) { return false; } \
+		CONCAT(pool_type, chunk) *chunk = mem; \
+		chunk->bytes = bytes; \
+		CONCAT(CONCAT(function_prefix, bp), lpushback)(&pool->chunks, chunk); \
+		pool->next = chunk->nodes; \
+		pool->end = chunk->nodes + pool->reserve; \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bpinit)(pool_type *pool, size_t reserve) { /*{{{*/ \
+		assert(pool != NULL); \
+		assert(reserve > 0); \
+		CONCAT(function_prefix, lclear)(&pool->free); \
+		CONCAT(CONCAT(function_prefix, bp), lclear)(&pool->chunks); \
+		pool->next = NULL; \
+		pool->end = NULL; \
+		pool->reserve = reserve; \
+		pool->touched = 0; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, bpget)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		if (pool->free.n > 0) { \
+			return CONCAT(function_prefix, lpopfront)(&pool->free); \
+		} \
+		if (pool->next == pool->end && !CONCAT(function_prefix, bpchunk)(pool)) { \
+			return NULL; \
+		} \
+		++pool->touched; \
+		return pool->next++; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bpreturn)(pool_type *pool, node_type *node) { /*{{{*/ \
+		assert(pool != NULL); \
+		assert(node != NULL); \
+		CONCAT(function_prefix, lpushback)(&pool->free, node); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bpreserved)(const pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		return pool->chunks.n * pool->reserve; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, bptouched)(const pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		return pool->touched; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, bpfree)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		CONCAT(pool_type, chunk) *chunk; \
+		while ((chunk = CONCAT(CONCAT(function_prefix, bp), lpopfront)(&pool->chunks)) != NULL) { \
+			munmap(chunk, chunk->bytes); \
+		} \
+		CONCAT(function_prefix, lclear)(&pool->free); \
+		pool->next = NULL; \
+		pool->end = NULL; \
+		pool->touched = 0; \
+	} /*}}}*/
@@ -0,0 +1,193 @@
+#pragma once
+
+/*
+ * latency aware queue with CoDel (controlled delay) dropping on top of sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_CODEL_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_CODEL_DECLS(mysll, mynode, mylist, mycodel);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_CODEL_DEFS(mysll, mynode, mylist, mycodel);
+ *
+ * where source stuff is appropriate, you get a queue type mycodel that timestamps nodes when they
+ * are pushed and measures their sojourn time when they are popped. Once the sojourn time has stayed
+ * above target for a whole interval, nodes are dropped from the head at an increasing rate
+ * (interval / sqrt(drops)) until the sojourn time falls below target again, as described in
+ * RFC 8289. Short bursts are absorbed, standing backlogs are not. Dropped nodes are not freed but
+ * diverted to the reject list of the queue, which the caller drains with the list functions.
+ *
+ * Time is in nanoseconds from the clock given at initialization, or CLOCK_MONOTONIC if NULL.
+ *
+ * void    mysll_cinit(mycodel *queue, uint64_t target, uint64_t interval, uint64_t (*clock)(void))
+ *                                                       // initializes an empty queue, 0 for target and interval gives
+ *                                                       // SLL_CODEL_TARGET and SLL_CODEL_INTERVAL
+ * size_t  mysll_csize(const mycodel *queue)             // returns the number of queued nodes
+ * void    mysll_cpushback(mycodel *queue, mynode *node) // timestamps and appends a node to the queue
+ * mynode *mysll_cpopfront(mycodel *queue)               // removes and returns the first node that is not dropped (or NULL)
+ * mylist *mysll_crejects(mycodel *queue)                // returns the list of dropped nodes
+ * size_t  mysll_cdrops(const mycodel *queue)            // returns the total number of dropped nodes
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "sll_meta.h"
+
+#ifndef SLL_CODEL_TARGET
+#define SLL_CODEL_TARGET (5*1000*1000u)
+#endif
+#ifndef SLL_CODEL_INTERVAL
+#define SLL_CODEL_INTERVAL (100*1000*1000u)
+#endif
+
+static inline uint64_t sll_codel_now(void) { /*{{{*/
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+} /*}}}*/
+
+static inline uint64_t sll_codel_isqrt(uint64_t x) { /*{{{*/
+	uint64_t r = x;
+	uint64_t y = (r + 1) / 2;
+	while (y < r) {
+		r = y;
+		y = (r + x / r) / 2;
+	}
+	return r;
+} /*}}}*/
+
+// in-type data addition
+#define SLL_CODEL_LINK uint64_t sll_codel_enqueued
+
+// header declarations
+#define SLL_CODEL_DECLS(function_prefix, node_type, list_type, codel_type) \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		list_type rejects; \
+		uint64_t (*clock)(void); \
+		uint64_t target; \
+		uint64_t interval; \
+		uint64_t first_above; \
+		uint64_t drop_next; \
+		size_t count; \
+		size_t lastcount; \
+		size_t drops; \
+		bool dropping; \
+	} codel_type; /*}}}*/ \
+	void       CONCAT(function_prefix, cinit)    (codel_type *queue, uint64_t target, uint64_t interval, uint64_t (*clock)(void)); \
+	size_t     CONCAT(function_prefix, csize)    (const codel_type *queue); \
+	void       CONCAT(function_prefix, cpushback)(codel_type *queue, node_type *node); \
+	node_type *CONCAT(function_prefix, cpopfront)(codel_type *queue); \
+	list_type *CONCAT(function_prefix, crejects) (codel_type *queue); \
+	size_t     CONCAT(function_prefix, cdrops)   (const codel_type *queue)
+
+// definitions
+
+#define SLL_CODEL_DEFS(function_prefix, node_type, list_type, codel_type) \
+	static uint64_t CONCAT(function_prefix, ccontrol)(const codel_type *queue, uint64_t t) { /*{{{*/ \
+		return t + queue->interval / sll_codel_isqrt(queue->count); \
+	} /*}}}*/ \
+	static node_type *CONCAT(function_prefix, cdequeue)(codel_type *queue, uint64_t now, bool *ok_to_drop) { /*{{{*/ \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&queue->list); \
+		*ok_to_drop = false; \
+		if (node == NULL) { \
+			queue->first_above = 0; \
+			return NULL; \
+		} \
+		uint64_t sojourn = now - node->sll_codel_enqueued; \
+		if (sojourn < queue->target) { \
+			queue->first_above = 0; \
+		} \
+		else if (queue->first_above == 0) { \
+			queue->first_above = now + queue->interval; \
+		} \
+		else if (now >= queue->first_above) { \
+			*ok_to_drop = true; \
+		} \
+		return node; \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, cdrop)(codel_type *queue, node_type *node) { /*{{{*/ \
+		CONCAT(function_prefix, lpushback)(&queue->rejects, node); \
+		++queue->drops; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, cinit)(codel_type *queue, uint64_t target, uint64_t interval, uint64_t (*clock)(void)) { /*{{{*/ \
+		assert(queue != NULL); \
+		CONCAT(function_prefix, lclear)(&queue->list); \
+		CONCAT(function_prefix, lclear)(&queue->rejects); \
+		queue->clock = clock != NULL ? clock : sll_codel_now; \
+		queue->target = target != 0 ? target : SLL_CODEL_TARGET; \
+		queue->interval = interval != 0 ? interval : SLL_CODEL_INTERVAL; \
+		queue->first_above = 0; \
+		queue->drop_next = 0; \
+		queue->count = 0; \
+		queue->lastcount = 0; \
+		queue->drops = 0; \
+		queue->dropping = false; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, csize)(const codel_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return queue->list.n; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, cpushback)(codel_type *queue, node_type *node) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(node != NULL); \
+		node->sll_codel_enqueued = queue->clock(); \
+		CONCAT(function_prefix, lpushback)(&queue->list, node); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, cpopfront)(codel_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		uint64_t now = queue->clock(); \
+		bool ok_to_drop; \
+		node_type *node = CONCAT(function_prefix, cdequeue)(queue, now, &ok_to_drop); \
+		if (queue->dropping) { \
+			if (!ok_to_drop) { \
+				queue->dropping = false; \
+			} \
+			while (queue->dropping && now >= queue->drop_next) { \
+				CONCAT(function_prefix, cdrop)(queue, node); \
+				++queue->count; \
+				node = CONCAT(function_prefix, cdequeue)(queue, now, &ok_to_drop); \
+				if (!ok_to_drop) { \
+					queue->dropping = false; \
+				} \
+				else { \
+					queue->drop_next = CONCAT(function_prefix, ccontrol)(queue, queue->drop_next); \
+				} \
+			} \
+		} \
+		else if (ok_to_drop) { \
+			CONCAT(function_prefix, cdrop)(queue, node); \
+			node = CONCAT(function_prefix, cdequeue)(queue, now, &ok_to_drop); \
+			queue->dropping = true; \
+			/* resume near the previous drop rate if we were dropping recently, drop_next may still */ \
+			/* be ahead of now, hence the signed difference as in the pseudocode of RFC 8289 */ \
+			size_t delta = queue->count - queue->lastcount; \
+			bool recent = (int64_t)(now - queue->drop_next) < (int64_t)(16 * queue->interval); \
+			queue->count = delta > 1 && recent ? delta : 1; \
+			queue->drop_next = CONCAT(function_prefix, ccontrol)(queue, now); \
+			queue->lastcount = queue->count; \
+		} \
+		return node; \
+	} /*}}}*/ \
+	list_type *CONCAT(function_prefix, crejects)(codel_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return &queue->rejects; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, cdrops)(const codel_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return queue->drops; \
+	} /*}}}*/
@@ -0,0 +1,382 @@
+#pragma once
+
+/*
+ * dependency graph (DAG) executor on top of the singly linked lists from sll_meta.h
+ *
+ * given a job type on the form
+ *
+ * typedef struct myjob myjob;
+ * SLL_DAG_EDGE_DECLS(mysll, myjob, myedge, myedgelist);
+ *
+ * struct myjob {
+ * 	...
+ * 	SLL_LINK(myjob);
+ * 	SLL_DAG_LINK(myjob, myedgelist);
+ * 	...
+ * };
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, myjob, myjoblist);
+ * SLL_DAG_DECLS(mysll, myjob, myjoblist, myedge, myedgelist, mygraph);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, myjob, myjoblist, jobfree);
+ * SLL_DAG_DEFS(mysll, myjob, myjoblist, myedge, myedgelist, mygraph);
+ *
+ * where source stuff is appropriate, you get a graph type mygraph where every job carries an
+ * atomic count of pending predecessors and an intrusive list of successor edges. When a job has
+ * run, the count of each successor is decremented, and successors reaching zero are pushed onto
+ * the run list of the worker that finished the job. Idle workers steal from the other run lists.
+ * Edges are carved out of slabs of SLL_DAG_SLAB edges when the graph is built, and the workers are
+ * started once and wait for runs between them, so running the graph allocates nothing and creates
+ * no threads, and the graph can be run any number of times. Without started workers, runs happen
+ * on the calling thread.
+ *
+ * The graph keeps track of its jobs through a separate link in SLL_DAG_LINK, so sll_link_next is
+ * free for the run lists and the graph stays intact across runs.
+ *
+ * void    mysll_dinit(mygraph *graph)                     // initializes an empty graph
+ * void    mysll_dadd(mygraph *graph, myjob *job)          // adds a job without any dependencies to the graph
+ * bool    mysll_dedge(mygraph *graph, myjob *from, myjob *to)
+ *                                                         // makes to depend on from, returns false if allocation fails
+ * size_t  mysll_dsize(const mygraph *graph)               // returns the number of jobs in the graph
+ * bool    mysll_dacyclic(mygraph *graph)                  // returns true if the graph has no cycles (single threaded, O(V+E))
+ * int     mysll_dstart(mygraph *graph, size_t nthreads)   // starts nthreads workers for the runs to come, returns 0 or an
+ *                                                         // error number, in which case no workers are left running
+ * void    mysll_dstop(mygraph *graph)                     // stops and joins the workers, not while a run is going on
+ * int     mysll_drun(mygraph *graph, void (*fn)(myjob *, void *), void *arg)
+ *                                                         // runs fn(job, arg) for every job in dependency order on the
+ *                                                         // workers, returns 0 or EDEADLK if the graph has a cycle
+ * void    mysll_dfree(mygraph *graph)                     // stops the workers, frees all edges and calls jobfree on all jobs
+ *
+ * Edges belong to the graph's slabs, so edge lists must never be freed by anything but dfree.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+#ifndef SLL_DAG_SLAB
+#define SLL_DAG_SLAB 4096
+#endif
+
+// edge type, needed before the job type is complete
+#define SLL_DAG_EDGE_DECLS(function_prefix, node_type, edge_type, edge_list_type) \
+	typedef struct edge_type { /*{{{*/ \
+		SLL_LINK(edge_type); \
+		node_type *to; \
+	} edge_type; /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, e), edge_type, edge_list_type)
+
+// in-type data addition
+#define SLL_DAG_LINK(node_type, edge_list_type) \
+	struct { \
+		struct node_type *all; \
+		atomic_size_t pending; \
+		size_t npred; \
+		edge_list_type succ; \
+	} sll_dag
+
+// header declarations
+#define SLL_DAG_DECLS(function_prefix, node_type, list_type, edge_type, edge_list_type, graph_type) \
+	typedef struct CONCAT(graph_type, slab) { /*{{{*/ \
+		SLL_LINK(CONCAT(graph_type, slab)); \
+		size_t used; \
+		edge_type edges[]; \
+	} CONCAT(graph_type, slab); /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, ds), CONCAT(graph_type, slab), CONCAT(graph_type, slablist)); \
+	typedef struct { /*{{{*/ \
+		list_type run; \
+		pthread_mutex_t lock; \
+		pthread_t thread; \
+		struct graph_type *graph; \
+		size_t index; \
+	} CONCAT(graph_type, worker); /*}}}*/ \
+	typedef struct graph_type { /*{{{*/ \
+		node_type *first; \
+		size_t n; \
+		CONCAT(graph_type, slablist) slabs; \
+		CONCAT(graph_type, worker) *workers; \
+		size_t nworkers; \
+		void (*fn)(node_type *, void *); \
+		void *arg; \
+		atomic_size_t remaining; \
+		atomic_size_t idle; \
+		atomic_bool deadlocked; \
+		pthread_mutex_t lock; \
+		pthread_cond_t cond; \
+		pthread_cond_t start; \
+		pthread_cond_t done; \
+		size_t generation; \
+		size_t active; \
+		bool stopping; \
+	} graph_type; /*}}}*/ \
+	void   CONCAT(function_prefix, dinit)   (graph_type *graph); \
+	void   CONCAT(function_prefix, dadd)    (graph_type *graph, node_type *job); \
+	bool   CONCAT(function_prefix, dedge)   (graph_type *graph, node_type *from, node_type *to); \
+	size_t CONCAT(function_prefix, dsize)   (const graph_type *graph); \
+	bool   CONCAT(function_prefix, dacyclic)(graph_type *graph); \
+	int    CONCAT(function_prefix, dstart)  (graph_type *graph, size_t nthreads); \
+	void   CONCAT(function_prefix, dstop)   (graph_type *graph); \
+	int    CONCAT(function_prefix, drun)    (graph_type *graph, void (*fn)(node_type *, void *), void *arg); \
+	void   CONCAT(function_prefix, dfree)   (graph_type *graph)
+
+// definitions
+
+#define SLL_DAG_DEFS(function_prefix, node_type, list_type, edge_type, edge_list_type, graph_type) \
+	/* edges live in the slabs, so freeing an edge list must not free them */ \
+	SLL_DEFS(CONCAT(function_prefix, e), edge_type, edge_list_type, (void)) \
+	SLL_DEFS(CONCAT(function_prefix, ds), CONCAT(graph_type, slab), CONCAT(graph_type, slablist), free) \
+	static void CONCAT(function_prefix, dreset)(graph_type *graph) { /*{{{*/ \
+		for (node_type *job = graph->first; job != NULL; job = job->sll_dag.all) { \
+			atomic_store_explicit(&job->sll_dag.pending, job->sll_dag.npred, memory_order_relaxed); \
+		} \
+	} /*}}}*/ \
+	static size_t CONCAT(function_prefix, dserial)(graph_type *graph, void (*fn)(node_type *, void *), void *arg) { /*{{{*/ \
+		/* runs the graph on the calling thread, fn may be NULL, returns the number of jobs reached */ \
+		list_type ready; \
+		size_t visited = 0; \
+		CONCAT(function_prefix, lclear)(&ready); \
+		CONCAT(function_prefix, dreset)(graph); \
+		for (node_type *job = graph->first; job != NULL; job = job->sll_dag.all) { \
+			if (job->sll_dag.npred == 0) { CONCAT(function_prefix, lpushback)(&ready, job); } \
+		} \
+		node_type *job; \
+		while ((job = CONCAT(function_prefix, lpopfront)(&ready)) != NULL) { \
+			if (fn != NULL) { fn(job, arg); } \
+			++visited; \
+			for (edge_type *edge = job->sll_dag.succ.first; edge != NULL; edge = SLL_NEXT(edge)) { \
+				if (atomic_fetch_sub_explicit(&edge->to->sll_dag.pending, 1, memory_order_relaxed) == 1) { \
+					CONCAT(function_prefix, lpushback)(&ready, edge->to); \
+				} \
+			} \
+		} \
+		return visited; \
+	} /*}}}*/ \
+	static bool CONCAT(function_prefix, dhaswork)(graph_type *graph) { /*{{{*/ \
+		for (size_t i=0; i<graph->nworkers; ++i) { \
+			pthread_mutex_lock(&graph->workers[i].lock); \
+			size_t n = graph->workers[i].run.n; \
+			pthread_mutex_unlock(&graph->workers[i].lock); \
+			if (n > 0) { return true; } \
+		} \
+		return false; \
+	} /*}}}*/ \
+	static node_type *CONCAT(function_prefix, dtake)(CONCAT(graph_type, worker) *worker) { /*{{{*/ \
+		graph_type *graph = worker->graph; \
+		for (;;) { \
+			if (atomic_load(&graph->remaining) == 0 || atomic_load(&graph->deadlocked)) { return NULL; } \
+			for (size_t i=0; i<graph->nworkers; ++i) { \
+				CONCAT(graph_type, worker) *victim = &graph->workers[(worker->index + i) % graph->nworkers]; \
+				pthread_mutex_lock(&victim->lock); \
+				node_type *job = CONCAT(function_prefix, lpopfront)(&victim->run); \
+				pthread_mutex_unlock(&victim->lock); \
+				if (job != NULL) { return job; } \
+			} \
+			pthread_mutex_lock(&graph->lock); \
+			size_t idle = atomic_fetch_add(&graph->idle, 1) + 1; \
+			if (!CONCAT(function_prefix, dhaswork)(graph) && atomic_load(&graph->remaining) > 0 && !atomic_load(&graph->deadlocked)) { \
+				if (idle == graph->nworkers) { \
+					/* nobody is running a job, so nothing will ever become ready */ \
+					atomic_store(&graph->deadlocked, true); \
+					pthread_cond_broadcast(&graph->cond); \
+				} \
+				else { \
+					pthread_cond_wait(&graph->cond, &graph->lock); \
+				} \
+			} \
+			atomic_fetch_sub(&graph->idle, 1); \
+			pthread_mutex_unlock(&graph->lock); \
+		} \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, dwork)(CONCAT(graph_type, worker) *worker) { /*{{{*/ \
+		graph_type *graph = worker->graph; \
+		list_type ready; \
+		CONCAT(function_prefix, lclear)(&ready); \
+		node_type *job; \
+		while ((job = CONCAT(function_prefix, dtake)(worker)) != NULL) { \
+			graph->fn(job, graph->arg); \
+			for (edge_type *edge = job->sll_dag.succ.first; edge != NULL; edge = SLL_NEXT(edge)) { \
+				if (atomic_fetch_sub_explicit(&edge->to->sll_dag.pending, 1, memory_order_acq_rel) == 1) { \
+					CONCAT(function_prefix, lpushback)(&ready, edge->to); \
+				} \
+			} \
+			size_t nready = ready.n; \
+			if (nready > 0) { \
+				pthread_mutex_lock(&worker->lock); \
+				CONCAT(function_prefix, lsplice)(&worker->run, &ready); \
+				pthread_mutex_unlock(&worker->lock); \
+			} \
+			bool last = atomic_fetch_sub(&graph->remaining, 1) == 1; \
+			if (last || (nready > 1 && atomic_load(&graph->idle) > 0)) { \
+				pthread_mutex_lock(&graph->lock); \
+				pthread_cond_broadcast(&graph->cond); \
+				pthread_mutex_unlock(&graph->lock); \
+			} \
+		} \
+	} /*}}}*/ \
+	static void *CONCAT(function_prefix, dworker)(void *p) { /*{{{*/ \
+		CONCAT(graph_type, worker) *worker = p; \
+		graph_type *graph = worker->graph; \
+		size_t seen = 0; \
+		pthread_mutex_lock(&graph->lock); \
+		for (;;) { \
+			while (graph->generation == seen && !graph->stopping) { \
+				pthread_cond_wait(&graph->start, &graph->lock); \
+			} \
+			if (graph->stopping) { break; } \
+			seen = graph->generation; \
+			pthread_mutex_unlock(&graph->lock); \
+			CONCAT(function_prefix, dwork)(worker); \
+			pthread_mutex_lock(&graph->lock); \
+			assert(graph->active > 0); \
+			if (--graph->active == 0) { pthread_cond_signal(&graph->done); } \
+		} \
+		pthread_mutex_unlock(&graph->lock); \
+		return NULL; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, dinit)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		graph->first = NULL; \
+		graph->n = 0; \
+		CONCAT(CONCAT(function_prefix, ds), lclear)(&graph->slabs); \
+		graph->workers = NULL; \
+		graph->nworkers = 0; \
+		pthread_mutex_init(&graph->lock, NULL); \
+		pthread_cond_init(&graph->cond, NULL); \
+		pthread_cond_init(&graph->start, NULL); \
+		pthread_cond_init(&graph->done, NULL); \
+		graph->generation = 0; \
+		graph->active = 0; \
+		graph->stopping = false; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, dadd)(graph_type *graph, node_type *job) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(job != NULL); \
+		job->sll_dag.all = graph->first; \
+		atomic_init(&job->sll_dag.pending, 0); \
+		job->sll_dag.npred = 0; \
+		CONCAT(CONCAT(function_prefix, e), lclear)(&job->sll_dag.succ); \
+		graph->first = job; \
+		++graph->n; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, dedge)(graph_type *graph, node_type *from, node_type *to) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(from != NULL); \
+		assert(to != NULL); \
+		CONCAT(graph_type, slab) *slab = graph->slabs.last; \
+		if (slab == NULL || slab->used == SLL_DAG_SLAB) { \
+			slab = malloc(sizeof(CONCAT(graph_type, slab)) + SLL_DAG_SLAB * sizeof(edge_type)); \
+			if (slab == NULL) { return false; } \
+			slab->used = 0; \
+			CONCAT(CONCAT(function_prefix, ds), lpushback)(&graph->slabs, slab); \
+		} \
+		edge_type *edge = &slab->edges[slab->used++]; \
+		edge->sll_link_next = NULL; /* no tags */ \
+		edge->to = to; \
+		CONCAT(CONCAT(function_prefix, e), lpushback)(&from->sll_dag.succ, edge); \
+		++to->sll_dag.npred; \
+		return true; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, dsize)(const graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		return graph->n; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, dacyclic)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		return CONCAT(function_prefix, dserial)(graph, NULL, NULL) == graph->n; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, dstart)(graph_type *graph, size_t nthreads) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(graph->nworkers == 0); \
+		if (nthreads == 0) { return 0; } \
+		graph->workers = calloc(nthreads, sizeof(CONCAT(graph_type, worker))); \
+		if (graph->workers == NULL) { return ENOMEM; } \
+		for (size_t i=0; i<nthreads; ++i) { \
+			CONCAT(function_prefix, lclear)(&graph->workers[i].run); \
+			pthread_mutex_init(&graph->workers[i].lock, NULL); \
+			graph->workers[i].graph = graph; \
+			graph->workers[i].index = i; \
+		} \
+		graph->stopping = false; \
+		for (; graph->nworkers<nthreads; ++graph->nworkers) { \
+			CONCAT(graph_type, worker) *worker = &graph->workers[graph->nworkers]; \
+			int ret = pthread_create(&worker->thread, NULL, CONCAT(function_prefix, dworker), worker); \
+			if (ret != 0) { \
+				/* dstop only destroys the locks of started workers */ \
+				for (size_t i=graph->nworkers; i<nthreads; ++i) { pthread_mutex_destroy(&graph->workers[i].lock); } \
+				CONCAT(function_prefix, dstop)(graph); \
+				return ret; \
+			} \
+		} \
+		return 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, dstop)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		pthread_mutex_lock(&graph->lock); \
+		graph->stopping = true; \
+		pthread_cond_broadcast(&graph->start); \
+		pthread_mutex_unlock(&graph->lock); \
+		for (size_t i=0; i<graph->nworkers; ++i) { \
+			pthread_join(graph->workers[i].thread, NULL); \
+			pthread_mutex_destroy(&graph->workers[i].lock); \
+		} \
+		/* workers of a later dstart count runs from 0 again */ \
+		graph->generation = 0; \
+		free(graph->workers); \
+		graph->workers = NULL; \
+		graph->nworkers = 0; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, drun)(graph_type *graph, void (*fn)(node_type *, void *), void *arg) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(fn != NULL); \
+		if (graph->n == 0) { return 0; } \
+		if (graph->nworkers == 0) { \
+			return CONCAT(function_prefix, dserial)(graph, fn, arg) == graph->n ? 0 : EDEADLK; \
+		} \
+		CONCAT(function_prefix, dreset)(graph); \
+		pthread_mutex_lock(&graph->lock); \
+		/* the workers are all waiting for the next generation, so their run lists are ours */ \
+		size_t nroots = 0; \
+		for (node_type *job = graph->first; job != NULL; job = job->sll_dag.all) { \
+			if (job->sll_dag.npred == 0) { \
+				CONCAT(function_prefix, lpushback)(&graph->workers[nroots++ % graph->nworkers].run, job); \
+			} \
+		} \
+		graph->fn = fn; \
+		graph->arg = arg; \
+		atomic_store(&graph->remaining, graph->n); \
+		atomic_store(&graph->idle, 0); \
+		atomic_store(&graph->deadlocked, false); \
+		graph->active = graph->nworkers; \
+		++graph->generation; \
+		pthread_cond_broadcast(&graph->start); \
+		while (graph->active > 0) { pthread_cond_wait(&graph->done, &graph->lock); } \
+		pthread_mutex_unlock(&graph->lock); \
+		return atomic_load(&graph->deadlocked) ? EDEADLK : 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, dfree)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		CONCAT(function_prefix, dstop)(graph); \
+		list_type jobs; \
+		CONCAT(function_prefix, lclear)(&jobs); \
+		node_type *job = graph->first; \
+		while (job != NULL) { \
+			node_type *next = job->sll_dag.all; \
+			CONCAT(function_prefix, lpushback)(&jobs, job); \
+			job = next; \
+		} \
+		CONCAT(CONCAT(function_prefix, ds), lfree)(&graph->slabs); \
+		pthread_cond_destroy(&graph->done); \
+		pthread_cond_destroy(&graph->start); \
+		pthread_cond_destroy(&graph->cond); \
+		pthread_mutex_destroy(&graph->lock); \
+		CONCAT(function_prefix, dinit)(graph); \
+		CONCAT(function_prefix, lfree)(&jobs); \
+	} /*}}}*/
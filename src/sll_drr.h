@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ * deficit round robin fair queueing over per flow lists, on top of sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_DRR_DECLS(mysll, mynode, mylist, myflow, mydrr);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DRR_DEFS(mysll, mynode, mylist, myflow, mydrr, nodecost);
+ *
+ * where source stuff is appropriate, gives you a flow type myflow (one per tenant or flow) holding a
+ * list of queued nodes, and a scheduler type mydrr keeping the flows that have nodes queued on an
+ * intrusive active list. Nodes are dequeued with deficit round robin: when a flow comes up, its
+ * deficit grows by its quantum, and it is served while the deficit covers the cost of its first node
+ * (as reported by size_t nodecost(const mynode *node)), after which the next flow comes up. Flows
+ * with nothing queued are not on the active list and cost nothing. Enqueue and dequeue are O(1) as
+ * long as quantum is at least the largest node cost; smaller quanta take more rounds per node.
+ *
+ * void    mysll_drinit(mydrr *drr)                          // initializes a scheduler without active flows
+ * void    mysll_drflowinit(myflow *flow, size_t quantum)    // initializes an idle flow, quantum must be > 0
+ * void    mysll_drpush(mydrr *drr, myflow *flow, mynode *node)
+ *                                                           // appends node to flow, activating the flow if it was idle
+ * mynode *mysll_drpop(mydrr *drr)                           // removes and returns the next node by DRR (or NULL)
+ * size_t  mysll_drsize(const mydrr *drr)                    // returns the number of queued nodes over all flows
+ * size_t  mysll_dractive(const mydrr *drr)                  // returns the number of flows with nodes queued
+ *
+ */
+
+#include <stdbool.h>
+#include "sll_meta.h"
+
+// header declarations
+#define SLL_DRR_DECLS(function_prefix, node_type, list_type, flow_type, drr_type) \
+	typedef struct flow_type { /*{{{*/ \
+		SLL_LINK(flow_type); \
+		list_type queue; \
+		size_t quantum; \
+		size_t deficit; \
+		bool active; \
+		bool turn; \
+	} flow_type; /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, dr), flow_type, CONCAT(flow_type, list)); \
+	typedef struct { /*{{{*/ \
+		CONCAT(flow_type, list) active; \
+		size_t n; \
+	} drr_type; /*}}}*/ \
+	void       CONCAT(function_prefix, drinit)    (drr_type *drr); \
+	void       CONCAT(function_prefix, drflowinit)(flow_type *flow, size_t quantum); \
+	void       CONCAT(function_prefix, drpush)    (drr_type *drr, flow_type *flow, node_type *node); \
+	node_type *CONCAT(function_prefix, drpop)     (drr_type *drr); \
+	size_t     CONCAT(function_prefix, drsize)    (const drr_type *drr); \
+	size_t     CONCAT(function_prefix, dractive)  (const drr_type *drr)
+
+// definitions
+
+#define SLL_DRR_DEFS(function_prefix, node_type, list_type, flow_type, drr_type, node_cost_func) \
+	/* flows are owned by the caller, so freeing the active list must not free them */ \
+	SLL_DEFS(CONCAT(function_prefix, dr), flow_type, CONCAT(flow_type, list), (void)) \
+	void CONCAT(function_prefix, drinit)(drr_type *drr) { /*{{{*/ \
+		assert(drr != NULL); \
+		CONCAT(CONCAT(function_prefix, dr), lclear)(&drr->active); \
+		drr->n = 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, drflowinit)(flow_type *flow, size_t quantum) { /*{{{*/ \
+		assert(flow != NULL); \
+		assert(quantum > 0); \
+		CONCAT(function_prefix, lclear)(&flow->queue); \
+		SLL_LNCLEAR(flow); \
+		flow->quantum = quantum; \
+		flow->deficit = 0; \
+		flow->active = false; \
+		flow->turn = false; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, drpush)(drr_type *drr, flow_type *flow, node_type *node) { /*{{{*/ \
+		assert(drr != NULL); \
+		assert(flow != NULL); \
+		assert(node != NULL); \
+		CONCAT(function_prefix, lpushback)(&flow->queue, node); \
+		++drr->n; \
+		if (!flow->active) { \
+			flow->active = true; \
+			CONCAT(CONCAT(function_prefix, dr), lpushback)(&drr->active, flow); \
+		} \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, drpop)(drr_type *drr) { /*{{{*/ \
+		assert(drr != NULL); \
+		for (;;) { \
+			flow_type *flow = drr->active.first; \
+			if (flow == NULL) { return NULL; } \
+			if (!flow->turn) { \
+				flow->deficit += flow->quantum; \
+				flow->turn = true; \
+			} \
+			size_t need = node_cost_func(flow->queue.first); \
+			if (flow->deficit < need) { \
+				/* out of credit for this round, go to the back of the line */ \
+				flow->turn = false; \
+				CONCAT(CONCAT(function_prefix, dr), lpopfront)(&drr->active); \
+				CONCAT(CONCAT(function_prefix, dr), lpushback)(&drr->active, flow); \
+				continue; \
+			} \
+			flow->deficit -= need; \
+			node_type *node = CONCAT(function_prefix, lpopfront)(&flow->queue); \
+			--drr->n; \
+			if (flow->queue.n == 0) { \
+				/* idle flows do not keep their credit */ \
+				flow->deficit = 0; \
+				flow->turn = false; \
+				flow->active = false; \
+				CONCAT(CONCAT(function_prefix, dr), lpopfront)(&drr->active); \
+			} \
+			return node; \
+		} \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, drsize)(const drr_type *drr) { /*{{{*/ \
+		assert(drr != NULL); \
+		return drr->n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, dractive)(const drr_type *drr) { /*{{{*/ \
+		assert(drr != NULL); \
+		return drr->active.n; \
+	} /*}}}*/
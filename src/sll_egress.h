@@ -0,0 +1,154 @@
+#pragma once
+
+/*
+ * zero copy egress of lists mixing memory buffers and file ranges, on top of sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_EGRESS_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_POOL_DECLS(mysll, mynode, mylist, mypool);
+ * SLL_EGRESS_DECLS(mysll, mynode, mylist, mypool);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_POOL_DEFS(mysll, mynode, mylist, mypool);
+ * SLL_EGRESS_DEFS(mysll, mynode, mylist, mypool);
+ *
+ * where source stuff is appropriate, every node describes either a memory buffer or a range of an
+ * open file, and a list of them can be written out in order without reading file contents into
+ * user space: runs of buffer nodes go out with one writev, file ranges with sendfile. Partial
+ * writes are handled by advancing the first unfinished node, so esend can simply be called again
+ * when the output becomes writable, and finished nodes are returned to the pool. Neither the
+ * buffers nor the file descriptors are owned by the nodes.
+ *
+ * void    mysll_esetbuf(mynode *node, const void *data, size_t len)
+ *                                                      // makes node describe len bytes at data
+ * void    mysll_esetfile(mynode *node, int fd, off_t offset, size_t len)
+ *                                                      // makes node describe len bytes of fd starting at offset
+ * size_t  mysll_elen(const mylist *list)               // returns the number of bytes left to send in the list
+ * ssize_t mysll_esend(mylist *list, mypool *pool, int out)
+ *                                                      // writes as much of the list to out as it takes without blocking
+ *                                                      // (or everything, for a blocking out), returning finished nodes
+ *                                                      // to pool, returns the number of bytes written, or -1 with errno
+ *                                                      // set if nothing could be written
+ *
+ */
+
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include "sll_meta.h"
+
+#ifndef SLL_EGRESS_IOV
+#define SLL_EGRESS_IOV 64
+#endif
+
+// in-type data addition
+#define SLL_EGRESS_LINK \
+	struct { \
+		const char *data; \
+		size_t len; \
+		off_t offset; \
+		int fd; \
+	} sll_egress
+
+// header declarations
+#define SLL_EGRESS_DECLS(function_prefix, node_type, list_type, pool_type) \
+	void    CONCAT(function_prefix, esetbuf) (node_type *node, const void *data, size_t len); \
+	void    CONCAT(function_prefix, esetfile)(node_type *node, int fd, off_t offset, size_t len); \
+	size_t  CONCAT(function_prefix, elen)    (const list_type *list); \
+	ssize_t CONCAT(function_prefix, esend)   (list_type *list, pool_type *pool, int out)
+
+// definitions
+
+#define SLL_EGRESS_DEFS(function_prefix, node_type, list_type, pool_type) \
+	static void CONCAT(function_prefix, eadvance)(list_type *list, pool_type *pool, size_t n) { /*{{{*/ \
+		while (n > 0) { \
+			node_type *node = list->first; \
+			if (n < node->sll_egress.len) { \
+				node->sll_egress.len -= n; \
+				if (node->sll_egress.fd < 0) { node->sll_egress.data += n; } \
+				else { node->sll_egress.offset += (off_t)n; } \
+				return; \
+			} \
+			n -= node->sll_egress.len; \
+			CONCAT(function_prefix, preturn)(pool, CONCAT(function_prefix, lpopfront)(list)); \
+		} \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, esetbuf)(node_type *node, const void *data, size_t len) { /*{{{*/ \
+		assert(node != NULL); \
+		assert(data != NULL || len == 0); \
+		node->sll_egress.data = data; \
+		node->sll_egress.len = len; \
+		node->sll_egress.offset = 0; \
+		node->sll_egress.fd = -1; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, esetfile)(node_type *node, int fd, off_t offset, size_t len) { /*{{{*/ \
+		assert(node != NULL); \
+		assert(fd >= 0); \
+		node->sll_egress.data = NULL; \
+		node->sll_egress.len = len; \
+		node->sll_egress.offset = offset; \
+		node->sll_egress.fd = fd; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, elen)(const list_type *list) { /*{{{*/ \
+		assert(list != NULL); \
+		size_t len = 0; \
+		for (const node_type *node = list->first; node != NULL; node = SLL_NEXT(node)) { \
+			len += node->sll_egress.len; \
+		} \
+		return len; \
+	} /*}}}*/ \
+	ssize_t CONCAT(function_prefix, esend)(list_type *list, pool_type *pool, int out) { /*{{{*/ \
+		assert(list != NULL); \
+		assert(pool != NULL); \
+		size_t total = 0; \
+		while (list->first != NULL) { \
+			node_type *node = list->first; \
+			ssize_t n; \
+			if (node->sll_egress.len == 0) { \
+				CONCAT(function_prefix, preturn)(pool, CONCAT(function_prefix, lpopfront)(list)); \
+				continue; \
+			} \
+			if (node->sll_egress.fd < 0) { \
+				struct iovec iov[SLL_EGRESS_IOV]; \
+				int iovcnt = 0; \
+				for (; node != NULL && node->sll_egress.fd < 0 && iovcnt < SLL_EGRESS_IOV; node = SLL_NEXT(node)) { \
+					iov[iovcnt].iov_base = (void *)(uintptr_t)node->sll_egress.data; \
+					iov[iovcnt].iov_len = node->sll_egress.len; \
+					++iovcnt; \
+				} \
+				n = writev(out, iov, iovcnt); \
+			} \
+			else { \
+				off_t offset = node->sll_egress.offset; \
+				n = sendfile(out, node->sll_egress.fd, &offset, node->sll_egress.len); \
+				if (n == 0) { \
+					/* the file is shorter than the range, which would otherwise spin forever */ \
+					errno = EIO; \
+					n = -1; \
+				} \
+			} \
+			if (n < 0) { \
+				if (errno == EINTR) { continue; } \
+				if (total > 0) { break; } \
+				return -1; \
+			} \
+			CONCAT(function_prefix, eadvance)(list, pool, (size_t)n); \
+			total += (size_t)n; \
+		} \
+		return (ssize_t)total; \
+	} /*}}}*/
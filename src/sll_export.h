@@ -0,0 +1,254 @@
+#pragma once
+
+/*
+ * compact binary export and import of integer keyed lists, on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS, SLL_DEFS, SLL_POOL_DECLS and SLL_POOL_DEFS as
+ * described in sll_meta.h, the following
+ *
+ * SLL_EXPORT_DECLS(mysll, mynode, mylist, mypool);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_EXPORT_DEFS(mysll, mynode, mylist, mypool, nodekey, nodeencode, nodedecode);
+ *
+ * where source stuff is appropriate, gives you a streaming export of a list to a file descriptor (a
+ * file, a pipe or a socket) and the matching import, e.g. to ship list snapshots between hosts. Every
+ * node is written as the difference of its key
+ *
+ * uint64_t nodekey(const mynode *node)
+ *
+ * to the key of the node before it, as a zigzag varint, followed by the rest of the node as the
+ * record written by
+ *
+ * size_t nodeencode(const mynode *node, void *buf)       // writes at most SLL_EXPORT_RECORD bytes, returns how many
+ *
+ * with its length as a varint in front. Lists sorted by key take a byte per key for keys closer
+ * than 64 apart, unsorted ones still round trip at up to ten bytes a key. Records are grouped in
+ * blocks of up to SLL_EXPORT_BLOCK bytes, each sent with a single write and guarded by a checksum,
+ * and an empty block ends the stream, so more data may follow it on the same descriptor. On import
+ * the checksum of a block is checked before any node is taken, then all nodes of the block are taken
+ * from the pool at once and the records are checked as they are decoded, each node filled in by
+ *
+ * bool nodedecode(mynode *node, uint64_t key, const void *buf, size_t len)
+ *                                                        // restores a node, false if the record is corrupt
+ *
+ * and linked up in a single pass with lthaw. A malformed record or a failed nodedecode returns all
+ * nodes of the block to the pool and fails the import. The stream header fields are little endian,
+ * the record contents are up to nodeencode and nodedecode, which must agree on a byte order of
+ * their own if the stream crosses architectures.
+ *
+ * int mysll_xexport(const mylist *list, int fd)          // writes all nodes of list to fd, returns 0 or an error number
+ * int mysll_ximport(mylist *list, mypool *pool, int fd)  // reads a stream from fd and appends its nodes to list, returns 0
+ *                                                        // or an error number (EIO for a corrupt stream), in which case
+ *                                                        // list is left as it was
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "sll_meta.h"
+
+#ifndef SLL_EXPORT_RECORD
+#define SLL_EXPORT_RECORD 4096
+#endif
+
+#ifndef SLL_EXPORT_BLOCK
+#define SLL_EXPORT_BLOCK (64*1024)
+#endif
+
+// magic, count, length and checksum of the payload, then length bytes of payload
+#define SLL_EXPORT_HEADER 16
+#define SLL_EXPORT_MAGIC  0x584c4c53u
+
+// worst case of a record: two varints and the encoded node
+#define SLL_EXPORT_MAXREC (10 + 5 + SLL_EXPORT_RECORD)
+
+_Static_assert(SLL_EXPORT_BLOCK >= SLL_EXPORT_MAXREC, "SLL_EXPORT_BLOCK must hold a record");
+_Static_assert(SLL_EXPORT_BLOCK <= UINT32_MAX, "SLL_EXPORT_BLOCK must fit the block header");
+
+static inline void sll_export_put32(unsigned char *buf, uint32_t v) {
+	buf[0] = (unsigned char)v;
+	buf[1] = (unsigned char)(v >> 8);
+	buf[2] = (unsigned char)(v >> 16);
+	buf[3] = (unsigned char)(v >> 24);
+}
+
+static inline uint32_t sll_export_get32(const unsigned char *buf) {
+	return (uint32_t)buf[0] | (uint32_t)buf[1] << 8 | (uint32_t)buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+static inline size_t sll_export_putvarint(unsigned char *buf, uint64_t v) {
+	size_t i = 0;
+	while (v >= 0x80) {
+		buf[i++] = (unsigned char)(v | 0x80);
+		v >>= 7;
+	}
+	buf[i++] = (unsigned char)v;
+	return i;
+}
+
+// returns the number of bytes taken, 0 if the varint runs past end or over 64 bits
+static inline size_t sll_export_getvarint(const unsigned char *buf, const unsigned char *end, uint64_t *v) {
+	uint64_t r = 0;
+	for (size_t i=0; i<10 && buf + i < end; ++i) {
+		r |= (uint64_t)(buf[i] & 0x7f) << (7 * i);
+		if ((buf[i] & 0x80) == 0) {
+			if (i == 9 && buf[i] > 1) { return 0; }
+			*v = r;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+// FNV-1a
+static inline uint32_t sll_export_checksum(const unsigned char *buf, size_t len) {
+	uint32_t h = 2166136261u;
+	for (size_t i=0; i<len; ++i) {
+		h = (h ^ buf[i]) * 16777619u;
+	}
+	return h;
+}
+
+static inline int sll_export_writeall(int fd, const unsigned char *buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = write(fd, buf, len);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) { return n < 0 ? errno : EIO; }
+		buf += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+// short reads are normal on pipes and sockets, running out of data early is a truncated stream
+static inline int sll_export_readall(int fd, unsigned char *buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = read(fd, buf, len);
+		if (n < 0 && errno == EINTR) { continue; }
+		if (n <= 0) { return n < 0 ? errno : EIO; }
+		buf += n;
+		len -= (size_t)n;
+	}
+	return 0;
+}
+
+// header declarations
+#define SLL_EXPORT_DECLS(function_prefix, node_type, list_type, pool_type) \
+	int CONCAT(function_prefix, xexport)(const list_type *list, int fd); \
+	int CONCAT(function_prefix, ximport)(list_type *list, pool_type *pool, int fd)
+
+// definitions
+
+#define SLL_EXPORT_DEFS(function_prefix, node_type, list_type, pool_type, node_key_func, node_encode_func, node_decode_func) \
+	static int CONCAT(function_prefix, xblock)(int fd, unsigned char *block, uint32_t count, size_t len) { /*{{{*/ \
+		sll_export_put32(block, SLL_EXPORT_MAGIC); \
+		sll_export_put32(block + 4, count); \
+		sll_export_put32(block + 8, (uint32_t)len); \
+		sll_export_put32(block + 12, sll_export_checksum(block + SLL_EXPORT_HEADER, len)); \
+		return sll_export_writeall(fd, block, SLL_EXPORT_HEADER + len); \
+	} /*}}}*/ \
+	static bool CONCAT(function_prefix, xalloc)(pool_type *pool, node_type **nodes, size_t n) { /*{{{*/ \
+		/* all pooled nodes first, then fresh ones for the rest */ \
+		size_t i = 0; \
+		while (i < n && (nodes[i] = CONCAT(function_prefix, lpopfront)((list_type*)pool)) != NULL) { ++i; } \
+		while (i < n && (nodes[i] = calloc(1, sizeof(node_type))) != NULL) { ++i; } \
+		if (i == n) { return true; } \
+		while (i-- > 0) { CONCAT(function_prefix, preturn)(pool, nodes[i]); } \
+		return false; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, xexport)(const list_type *list, int fd) { /*{{{*/ \
+		assert(list != NULL); \
+		unsigned char *block = malloc(SLL_EXPORT_HEADER + SLL_EXPORT_BLOCK); \
+		if (block == NULL) { return ENOMEM; } \
+		unsigned char *payload = block + SLL_EXPORT_HEADER; \
+		size_t len = 0; \
+		uint32_t count = 0; \
+		uint64_t prev = 0; \
+		int err = 0; \
+		for (const node_type *node = list->first; node != NULL; node = SLL_NEXT(node)) { \
+			if (SLL_EXPORT_BLOCK - len < SLL_EXPORT_MAXREC) { \
+				if ((err = CONCAT(function_prefix, xblock)(fd, block, count, len)) != 0) { break; } \
+				len = 0; \
+				count = 0; \
+				prev = 0; \
+			} \
+			/* keys are relative to the previous one in the same block, so blocks decode on their own */ \
+			uint64_t nkey = node_key_func(node); \
+			uint64_t delta = nkey - prev; \
+			len += sll_export_putvarint(payload + len, (delta << 1) ^ -(delta >> 63)); \
+			prev = nkey; \
+			/* the record goes after the room its length may need, and is moved down if that was less */ \
+			size_t size = node_encode_func(node, payload + len + 5); \
+			assert(size <= SLL_EXPORT_RECORD); \
+			size_t lenlen = sll_export_putvarint(payload + len, size); \
+			if (lenlen < 5) { memmove(payload + len + lenlen, payload + len + 5, size); } \
+			len += lenlen + size; \
+			++count; \
+		} \
+		if (err == 0 && count > 0) { err = CONCAT(function_prefix, xblock)(fd, block, count, len); } \
+		if (err == 0) { err = CONCAT(function_prefix, xblock)(fd, block, 0, 0); } \
+		free(block); \
+		return err; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, ximport)(list_type *list, pool_type *pool, int fd) { /*{{{*/ \
+		assert(list != NULL); \
+		assert(pool != NULL); \
+		/* a record takes at least two bytes, which bounds the nodes per block */ \
+		unsigned char *payload = malloc(SLL_EXPORT_BLOCK); \
+		node_type **nodes = malloc(SLL_EXPORT_BLOCK / 2 * sizeof(node_type *)); \
+		list_type imported; \
+		CONCAT(function_prefix, lclear)(&imported); \
+		int err = payload == NULL || nodes == NULL ? ENOMEM : 0; \
+		while (err == 0) { \
+			unsigned char header[SLL_EXPORT_HEADER]; \
+			if ((err = sll_export_readall(fd, header, sizeof(header))) != 0) { break; } \
+			uint32_t count = sll_export_get32(header + 4); \
+			uint32_t len = sll_export_get32(header + 8); \
+			if (sll_export_get32(header) != SLL_EXPORT_MAGIC || len > SLL_EXPORT_BLOCK || count > len / 2) { \
+				err = EIO; \
+				break; \
+			} \
+			if ((err = sll_export_readall(fd, payload, len)) != 0) { break; } \
+			if (sll_export_checksum(payload, len) != sll_export_get32(header + 12)) { \
+				err = EIO; \
+				break; \
+			} \
+			if (count == 0) { break; } \
+			if (!CONCAT(function_prefix, xalloc)(pool, nodes, count)) { \
+				err = ENOMEM; \
+				break; \
+			} \
+			const unsigned char *pos = payload, *end = payload + len; \
+			uint64_t prev = 0; \
+			for (uint32_t i=0; i<count && err == 0; ++i) { \
+				uint64_t zigzag, size; \
+				size_t took = sll_export_getvarint(pos, end, &zigzag); \
+				size_t lentook = took > 0 ? sll_export_getvarint(pos + took, end, &size) : 0; \
+				if (lentook == 0 || size > SLL_EXPORT_RECORD || size > (size_t)(end - pos - took - lentook)) { \
+					err = EIO; \
+					break; \
+				} \
+				pos += took + lentook; \
+				prev += (zigzag >> 1) ^ -(zigzag & 1); \
+				if (!node_decode_func(nodes[i], prev, pos, size)) { err = EIO; } \
+				pos += size; \
+			} \
+			if (err == 0 && pos != end) { err = EIO; } \
+			if (err != 0) { \
+				for (uint32_t i=0; i<count; ++i) { CONCAT(function_prefix, preturn)(pool, nodes[i]); } \
+				break; \
+			} \
+			list_type block; \
+			CONCAT(function_prefix, lthaw)(&block, nodes, count); \
+			CONCAT(function_prefix, lsplice)(&imported, &block); \
+		} \
+		if (err == 0) { CONCAT(function_prefix, lsplice)(list, &imported); } \
+		else { CONCAT(function_prefix, lsplice)((list_type*)pool, &imported); } \
+		free(payload); \
+		free(nodes); \
+		return err; \
+	} /*}}}*/
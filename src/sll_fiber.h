@@ -0,0 +1,487 @@
+#pragma once
+
+/*
+ * user-space fibers (green threads) on top of the singly linked lists from sll_meta.h
+ *
+ * given a fiber control block type on the form
+ *
+ * struct myfiber {
+ * 	SLL_LINK(myfiber);
+ * 	SLL_FIBER_LINK(myfiber, mysched);
+ * 	...
+ * } myfiber;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(myfib, myfiber, myfiberlist);
+ * SLL_FIBER_DECLS(myfib, myfiber, myfiberlist, mysched, mywait);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(myfib, myfiber, myfiberlist, free);
+ * SLL_FIBER_DEFS(myfib, myfiber, myfiberlist, mysched, mywait, fiberdone);
+ *
+ * where source stuff is appropriate, you get a scheduler type mysched running any number of fibers
+ * on one OS thread. Run one scheduler per core (one OS thread calling mysched_srun each) to get
+ * M fibers on N threads. Fibers stay on the scheduler they were spawned on, but may be woken from
+ * any thread. Every scheduler keeps its runnable fibers on a ready list, sleeping fibers on a timer
+ * list sorted by wake time and fibers woken from other threads on a locked remote list that the
+ * scheduler splices into its ready list, taking the lock only when a flag says there is something
+ * to splice. Fibers blocked on a mywait are kept on its waiters list. No OS thread is blocked while
+ * a fiber waits, and no memory is allocated per context switch.
+ *
+ * Fiber stacks are carved out of slabs of SLL_FIBER_SLAB stacks, each slab a single mapping made
+ * without reservation, so pages are only backed once they are touched. Below every stack is a
+ * guard page, unless SLL_FIBER_GUARD is defined to 0. Guard regions (MADV_GUARD_INSTALL, Linux
+ * 6.13) keep a slab one entry in the process memory map, on older kernels the guards fall back to
+ * mprotect, which costs two entries per stack and runs into vm.max_map_count at about 32k fibers,
+ * so go without guards there for more. A stack goes back to its scheduler when the fiber has
+ * returned, and the slabs are released by sdestroy. When a fiber has returned,
+ * fiberdone(myfiber *fiber) is called from the scheduler, which is where the control block should
+ * be returned to a pool or freed.
+ *
+ * void     myfib_sinit(mysched *sched, size_t stacksize) // initializes a scheduler, stacksize 0 gives SLL_FIBER_STACKSIZE
+ * void     myfib_sdestroy(mysched *sched)                // releases scheduler resources, the scheduler must have no live fibers
+ * void     myfib_srun(mysched *sched)                    // runs the scheduler on the calling thread until it has no live fibers
+ * bool     myfib_fspawn(mysched *sched, myfiber *fiber, void (*fn)(myfiber *))
+ *                                                        // makes fiber runnable on sched, running fn(fiber), callable from
+ *                                                        // any thread, fiber must be zeroed or previously run to completion
+ *                                                        // returns false if no stack could be allocated
+ * myfiber *myfib_fself(void)                             // returns the calling fiber (or NULL outside of a fiber)
+ * void     myfib_fyield(void)                            // lets other runnable fibers on the same scheduler run
+ * void     myfib_fsleep(uint64_t ns)                     // parks the calling fiber for at least ns nanoseconds
+ * void     myfib_wclear(mywait *wait)                    // initializes an empty wait list
+ * void     myfib_wdestroy(mywait *wait)                  // releases wait list resources, nothing may be parked on it
+ * void     myfib_wpark(mywait *wait, pthread_mutex_t *lock)
+ *                                                        // parks the calling fiber on wait, lock must be held and guard wait,
+ *                                                        // it is released while parked and held again on return
+ * bool     myfib_wwake(mywait *wait)                     // wakes the first parked fiber, lock must be held, returns false if none
+ * size_t   myfib_wwakeall(mywait *wait)                  // wakes all parked fibers, lock must be held, returns how many
+ *
+ * Called from a plain OS thread rather than a fiber, fyield and fsleep yield and sleep the thread,
+ * and wpark blocks the thread on a condition variable until a wwake meant for it; parked fibers
+ * are woken before parked threads.
+ *
+ * FIBER QUEUE FUNCTIONS
+ *
+ * If you make use of SLL_FIBER_QUEUE_DECLS and SLL_FIBER_QUEUE_DEFS with parameters
+ * (mysll, mynode, mylist, myfqueue, myfib, mywait) for some other list of mynode, you get a
+ * thread safe queue where a fiber popping from an empty queue is parked instead of its OS thread
+ *
+ * void    mysll_fqinit(myfqueue *queue)                  // initializes an empty queue
+ * void    mysll_fqdestroy(myfqueue *queue)               // releases queue resources, nodes still queued are left alone
+ * void    mysll_fqpush(myfqueue *queue, mynode *node)    // appends a node and wakes one parked consumer
+ * mynode *mysll_fqpop(myfqueue *queue)                   // removes and returns the first node, parking the caller while empty
+ * mynode *mysll_fqtrypop(myfqueue *queue)                // removes and returns the first node (or NULL), never parks
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "sll_meta.h"
+
+#ifndef SLL_FIBER_STACKSIZE
+#define SLL_FIBER_STACKSIZE (64*1024)
+#endif
+
+#ifndef SLL_FIBER_SLAB
+#define SLL_FIBER_SLAB 64
+#endif
+
+#ifndef SLL_FIBER_GUARD
+#define SLL_FIBER_GUARD 1
+#endif
+
+#ifndef MADV_GUARD_INSTALL
+#define MADV_GUARD_INSTALL 102
+#endif
+
+enum {
+	SLL_FIBER_READY = 0,
+	SLL_FIBER_RUNNING,
+	SLL_FIBER_PARKED,
+	SLL_FIBER_SLEEPING,
+	SLL_FIBER_DEAD
+};
+
+static inline uint64_t sll_fiber_now(void) { /*{{{*/
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+} /*}}}*/
+
+// returns false if the page could not be made a guard
+static inline bool sll_fiber_guard(void *page, size_t size) { /*{{{*/
+	if (madvise(page, size, MADV_GUARD_INSTALL) == 0) { return true; }
+	return mprotect(page, size, PROT_NONE) == 0;
+} /*}}}*/
+
+// in-type data addition
+#define SLL_FIBER_LINK(node_type, sched_type) \
+	struct { \
+		ucontext_t ctx; \
+		void *stack; \
+		void (*fn)(struct node_type *); \
+		struct sched_type *sched; \
+		uint64_t wake; \
+		atomic_int state; \
+	} sll_fiber
+
+// header declarations
+#define SLL_FIBER_DECLS(function_prefix, node_type, list_type, sched_type, wait_type) \
+	typedef struct sched_type { /*{{{*/ \
+		list_type ready; \
+		list_type timers; \
+		list_type remote; \
+		atomic_bool remoted; \
+		pthread_mutex_t lock; \
+		pthread_cond_t cond; \
+		ucontext_t ctx; \
+		node_type *current; \
+		atomic_size_t live; \
+		size_t stacksize; \
+		size_t guardsize; \
+		void *stacks; \
+		void *slabs; \
+	} sched_type; /*}}}*/ \
+	typedef struct { /*{{{*/ \
+		list_type waiters; \
+		pthread_cond_t cond; \
+		size_t threads; \
+		size_t wakeups; \
+	} wait_type; /*}}}*/ \
+	void       CONCAT(function_prefix, sinit)     (sched_type *sched, size_t stacksize); \
+	void       CONCAT(function_prefix, sdestroy)  (sched_type *sched); \
+	void       CONCAT(function_prefix, srun)      (sched_type *sched); \
+	bool       CONCAT(function_prefix, fspawn)    (sched_type *sched, node_type *fiber, void (*fn)(node_type *)); \
+	node_type *CONCAT(function_prefix, fself)     (void); \
+	void       CONCAT(function_prefix, fyield)    (void); \
+	void       CONCAT(function_prefix, fsleep)    (uint64_t ns); \
+	void       CONCAT(function_prefix, wclear)    (wait_type *wait); \
+	void       CONCAT(function_prefix, wdestroy)  (wait_type *wait); \
+	void       CONCAT(function_prefix, wpark)     (wait_type *wait, pthread_mutex_t *lock); \
+	bool       CONCAT(function_prefix, wwake)     (wait_type *wait); \
+	size_t     CONCAT(function_prefix, wwakeall)  (wait_type *wait)
+
+#define SLL_FIBER_QUEUE_DECLS(function_prefix, node_type, list_type, queue_type, fiber_prefix, wait_type) \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		wait_type waiters; \
+		pthread_mutex_t lock; \
+	} queue_type; /*}}}*/ \
+	void       CONCAT(function_prefix, fqinit)   (queue_type *queue); \
+	void       CONCAT(function_prefix, fqdestroy)(queue_type *queue); \
+	void       CONCAT(function_prefix, fqpush)   (queue_type *queue, node_type *node); \
+	node_type *CONCAT(function_prefix, fqpop)    (queue_type *queue); \
+	node_type *CONCAT(function_prefix, fqtrypop) (queue_type *queue)
+
+// definitions
+
+/*
+ * A slab is a header page, holding the link to the next slab, followed by SLL_FIBER_SLAB times a
+ * guard page and a stack. Free stacks are chained through their topmost word.
+ */
+#define SLL_FIBER_DEFS(function_prefix, node_type, list_type, sched_type, wait_type, fiber_done_func) \
+	static _Thread_local sched_type *CONCAT(function_prefix, tls_sched) = NULL; \
+	static void CONCAT(function_prefix, ftrampoline)(void) { /*{{{*/ \
+		sched_type *sched = CONCAT(function_prefix, tls_sched); \
+		node_type *fiber = sched->current; \
+		fiber->sll_fiber.fn(fiber); \
+		atomic_store_explicit(&fiber->sll_fiber.state, SLL_FIBER_DEAD, memory_order_relaxed); \
+		/* returning resumes the scheduler through uc_link */ \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, fswitch)(node_type *fiber, int state) { /*{{{*/ \
+		sched_type *sched = fiber->sll_fiber.sched; \
+		atomic_store_explicit(&fiber->sll_fiber.state, state, memory_order_relaxed); \
+		swapcontext(&fiber->sll_fiber.ctx, &sched->ctx); \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, fready)(node_type *fiber) { /*{{{*/ \
+		sched_type *sched = fiber->sll_fiber.sched; \
+		/* a waker on another thread stores this while the scheduler may look at it, hence the atomic */ \
+		atomic_store_explicit(&fiber->sll_fiber.state, SLL_FIBER_READY, memory_order_relaxed); \
+		if (CONCAT(function_prefix, tls_sched) == sched) { \
+			CONCAT(function_prefix, lpushback)(&sched->ready, fiber); \
+			return; \
+		} \
+		pthread_mutex_lock(&sched->lock); \
+		CONCAT(function_prefix, lpushback)(&sched->remote, fiber); \
+		atomic_store_explicit(&sched->remoted, true, memory_order_release); \
+		pthread_cond_signal(&sched->cond); \
+		pthread_mutex_unlock(&sched->lock); \
+	} /*}}}*/ \
+	static void **CONCAT(function_prefix, fstacklink)(const sched_type *sched, void *stack) { /*{{{*/ \
+		return (void **)((char *)stack + sched->stacksize) - 1; \
+	} /*}}}*/ \
+	static bool CONCAT(function_prefix, fslab)(sched_type *sched) { /*{{{*/ \
+		/* called with the lock held */ \
+		size_t page = (size_t)sysconf(_SC_PAGESIZE); \
+		size_t stride = sched->guardsize + sched->stacksize; \
+		size_t size = page + SLL_FIBER_SLAB * stride; \
+		char *slab = mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE|MAP_STACK, -1, 0); \
+		if (slab == MAP_FAILED) { return false; } \
+		for (size_t i=0; i<SLL_FIBER_SLAB && sched->guardsize > 0; ++i) { \
+			if (!sll_fiber_guard(slab + page + i * stride, sched->guardsize)) { \
+				munmap(slab, size); \
+				return false; \
+			} \
+		} \
+		*(void **)slab = sched->slabs; \
+		sched->slabs = slab; \
+		for (size_t i=SLL_FIBER_SLAB; i-- > 0; ) { \
+			void *stack = slab + page + i * stride + sched->guardsize; \
+			*CONCAT(function_prefix, fstacklink)(sched, stack) = sched->stacks; \
+			sched->stacks = stack; \
+		} \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, sinit)(sched_type *sched, size_t stacksize) { /*{{{*/ \
+		assert(sched != NULL); \
+		pthread_condattr_t attr; \
+		size_t page = (size_t)sysconf(_SC_PAGESIZE); \
+		CONCAT(function_prefix, lclear)(&sched->ready); \
+		CONCAT(function_prefix, lclear)(&sched->timers); \
+		CONCAT(function_prefix, lclear)(&sched->remote); \
+		atomic_init(&sched->remoted, false); \
+		pthread_mutex_init(&sched->lock, NULL); \
+		pthread_condattr_init(&attr); \
+		pthread_condattr_setclock(&attr, CLOCK_MONOTONIC); \
+		pthread_cond_init(&sched->cond, &attr); \
+		pthread_condattr_destroy(&attr); \
+		sched->current = NULL; \
+		atomic_init(&sched->live, 0); \
+		stacksize = stacksize != 0 ? stacksize : SLL_FIBER_STACKSIZE; \
+		sched->stacksize = (stacksize + page - 1) / page * page; \
+		sched->guardsize = SLL_FIBER_GUARD ? page : 0; \
+		sched->stacks = NULL; \
+		sched->slabs = NULL; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, sdestroy)(sched_type *sched) { /*{{{*/ \
+		assert(sched != NULL); \
+		assert(atomic_load(&sched->live) == 0); \
+		size_t size = (size_t)sysconf(_SC_PAGESIZE) + SLL_FIBER_SLAB * (sched->guardsize + sched->stacksize); \
+		while (sched->slabs != NULL) { \
+			void *slab = sched->slabs; \
+			sched->slabs = *(void **)slab; \
+			munmap(slab, size); \
+		} \
+		sched->stacks = NULL; \
+		pthread_cond_destroy(&sched->cond); \
+		pthread_mutex_destroy(&sched->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, srun)(sched_type *sched) { /*{{{*/ \
+		assert(sched != NULL); \
+		assert(CONCAT(function_prefix, tls_sched) == NULL); \
+		CONCAT(function_prefix, tls_sched) = sched; \
+		for (;;) { \
+			if (atomic_load_explicit(&sched->remoted, memory_order_acquire)) { \
+				pthread_mutex_lock(&sched->lock); \
+				atomic_store_explicit(&sched->remoted, false, memory_order_relaxed); \
+				CONCAT(function_prefix, lsplice)(&sched->ready, &sched->remote); \
+				pthread_mutex_unlock(&sched->lock); \
+			} \
+			/* fibers are counted before they are queued, so none can be on the way at zero */ \
+			if (atomic_load_explicit(&sched->live, memory_order_acquire) == 0) { break; } \
+			if (sched->timers.n > 0) { \
+				uint64_t now = sll_fiber_now(); \
+				while (sched->timers.first != NULL && sched->timers.first->sll_fiber.wake <= now) { \
+					node_type *fiber = CONCAT(function_prefix, lpopfront)(&sched->timers); \
+					atomic_store_explicit(&fiber->sll_fiber.state, SLL_FIBER_READY, memory_order_relaxed); \
+					CONCAT(function_prefix, lpushback)(&sched->ready, fiber); \
+				} \
+			} \
+			node_type *fiber = CONCAT(function_prefix, lpopfront)(&sched->ready); \
+			if (fiber == NULL) { \
+				pthread_mutex_lock(&sched->lock); \
+				if (sched->remote.n == 0) { \
+					if (sched->timers.n > 0) { \
+						uint64_t wake = sched->timers.first->sll_fiber.wake; \
+						struct timespec ts = { .tv_sec = wake / 1000000000u, .tv_nsec = wake % 1000000000u }; \
+						pthread_cond_timedwait(&sched->cond, &sched->lock, &ts); \
+					} \
+					else { \
+						pthread_cond_wait(&sched->cond, &sched->lock); \
+					} \
+				} \
+				pthread_mutex_unlock(&sched->lock); \
+				continue; \
+			} \
+			sched->current = fiber; \
+			atomic_store_explicit(&fiber->sll_fiber.state, SLL_FIBER_RUNNING, memory_order_relaxed); \
+			swapcontext(&sched->ctx, &fiber->sll_fiber.ctx); \
+			sched->current = NULL; \
+			if (atomic_load_explicit(&fiber->sll_fiber.state, memory_order_relaxed) == SLL_FIBER_DEAD) { \
+				pthread_mutex_lock(&sched->lock); \
+				*CONCAT(function_prefix, fstacklink)(sched, fiber->sll_fiber.stack) = sched->stacks; \
+				sched->stacks = fiber->sll_fiber.stack; \
+				pthread_mutex_unlock(&sched->lock); \
+				fiber->sll_fiber.stack = NULL; \
+				atomic_fetch_sub_explicit(&sched->live, 1, memory_order_release); \
+				fiber_done_func(fiber); \
+			} \
+		} \
+		CONCAT(function_prefix, tls_sched) = NULL; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, fspawn)(sched_type *sched, node_type *fiber, void (*fn)(node_type *)) { /*{{{*/ \
+		assert(sched != NULL); \
+		assert(fiber != NULL); \
+		assert(fn != NULL); \
+		pthread_mutex_lock(&sched->lock); \
+		if (sched->stacks == NULL && !CONCAT(function_prefix, fslab)(sched)) { \
+			pthread_mutex_unlock(&sched->lock); \
+			return false; \
+		} \
+		void *stack = sched->stacks; \
+		sched->stacks = *CONCAT(function_prefix, fstacklink)(sched, stack); \
+		pthread_mutex_unlock(&sched->lock); \
+		fiber->sll_fiber.stack = stack; \
+		getcontext(&fiber->sll_fiber.ctx); \
+		fiber->sll_fiber.ctx.uc_stack.ss_sp = stack; \
+		fiber->sll_fiber.ctx.uc_stack.ss_size = sched->stacksize; \
+		fiber->sll_fiber.ctx.uc_link = &sched->ctx; \
+		makecontext(&fiber->sll_fiber.ctx, CONCAT(function_prefix, ftrampoline), 0); \
+		fiber->sll_fiber.fn = fn; \
+		fiber->sll_fiber.sched = sched; \
+		fiber->sll_fiber.wake = 0; \
+		atomic_fetch_add_explicit(&sched->live, 1, memory_order_relaxed); \
+		CONCAT(function_prefix, fready)(fiber); \
+		return true; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, fself)(void) { /*{{{*/ \
+		sched_type *sched = CONCAT(function_prefix, tls_sched); \
+		return sched != NULL ? sched->current : NULL; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, fyield)(void) { /*{{{*/ \
+		node_type *fiber = CONCAT(function_prefix, fself)(); \
+		if (fiber == NULL) { \
+			sched_yield(); \
+			return; \
+		} \
+		CONCAT(function_prefix, lpushback)(&fiber->sll_fiber.sched->ready, fiber); \
+		CONCAT(function_prefix, fswitch)(fiber, SLL_FIBER_READY); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, fsleep)(uint64_t ns) { /*{{{*/ \
+		node_type *fiber = CONCAT(function_prefix, fself)(); \
+		if (fiber == NULL) { \
+			struct timespec ts = { .tv_sec = ns / 1000000000u, .tv_nsec = ns % 1000000000u }; \
+			while (nanosleep(&ts, &ts) != 0 && errno == EINTR) { } \
+			return; \
+		} \
+		list_type *timers = &fiber->sll_fiber.sched->timers; \
+		fiber->sll_fiber.wake = sll_fiber_now() + ns; \
+		if (timers->n == 0 || timers->last->sll_fiber.wake <= fiber->sll_fiber.wake) { \
+			CONCAT(function_prefix, lpushback)(timers, fiber); \
+		} \
+		else if (fiber->sll_fiber.wake < timers->first->sll_fiber.wake) { \
+			SLL_SETNEXT(fiber, timers->first); \
+			timers->first = fiber; \
+			++timers->n; \
+		} \
+		else { \
+			node_type *prev = timers->first; \
+			while (SLL_NEXT(prev)->sll_fiber.wake <= fiber->sll_fiber.wake) { \
+				prev = SLL_NEXT(prev); \
+			} \
+			SLL_SETNEXT(fiber, SLL_NEXT(prev)); \
+			SLL_SETNEXT(prev, fiber); \
+			++timers->n; \
+		} \
+		CONCAT(function_prefix, fswitch)(fiber, SLL_FIBER_SLEEPING); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, wclear)(wait_type *wait) { /*{{{*/ \
+		assert(wait != NULL); \
+		CONCAT(function_prefix, lclear)(&wait->waiters); \
+		pthread_cond_init(&wait->cond, NULL); \
+		wait->threads = 0; \
+		wait->wakeups = 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, wdestroy)(wait_type *wait) { /*{{{*/ \
+		assert(wait != NULL); \
+		assert(wait->waiters.n == 0 && wait->threads == 0); \
+		pthread_cond_destroy(&wait->cond); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, wpark)(wait_type *wait, pthread_mutex_t *lock) { /*{{{*/ \
+		assert(wait != NULL); \
+		assert(lock != NULL); \
+		node_type *fiber = CONCAT(function_prefix, fself)(); \
+		if (fiber == NULL) { \
+			/* a plain thread, wakeups are counted so that spurious ones are not taken for real */ \
+			++wait->threads; \
+			while (wait->wakeups == 0) { pthread_cond_wait(&wait->cond, lock); } \
+			--wait->wakeups; \
+			--wait->threads; \
+			return; \
+		} \
+		/* the state is set while no waker can see the fiber yet, so it cannot overwrite a wakeup */ \
+		atomic_store_explicit(&fiber->sll_fiber.state, SLL_FIBER_PARKED, memory_order_relaxed); \
+		CONCAT(function_prefix, lpushback)(&wait->waiters, fiber); \
+		pthread_mutex_unlock(lock); \
+		/* a waker on another thread can only reach the remote list, which the scheduler */ \
+		/* drains after this switch has completed, so the unlock above is not racy */ \
+		swapcontext(&fiber->sll_fiber.ctx, &fiber->sll_fiber.sched->ctx); \
+		pthread_mutex_lock(lock); \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, wwake)(wait_type *wait) { /*{{{*/ \
+		assert(wait != NULL); \
+		node_type *fiber = CONCAT(function_prefix, lpopfront)(&wait->waiters); \
+		if (fiber != NULL) { \
+			CONCAT(function_prefix, fready)(fiber); \
+			return true; \
+		} \
+		if (wait->threads > wait->wakeups) { \
+			++wait->wakeups; \
+			pthread_cond_signal(&wait->cond); \
+			return true; \
+		} \
+		return false; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, wwakeall)(wait_type *wait) { /*{{{*/ \
+		size_t n = 0; \
+		while (CONCAT(function_prefix, wwake)(wait)) { ++n; } \
+		return n; \
+	} /*}}}*/
+
+#define SLL_FIBER_QUEUE_DEFS(function_prefix, node_type, list_type, queue_type, fiber_prefix, wait_type) \
+	void CONCAT(function_prefix, fqinit)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		CONCAT(function_prefix, lclear)(&queue->list); \
+		CONCAT(fiber_prefix, wclear)(&queue->waiters); \
+		pthread_mutex_init(&queue->lock, NULL); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, fqdestroy)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		CONCAT(fiber_prefix, wdestroy)(&queue->waiters); \
+		pthread_mutex_destroy(&queue->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, fqpush)(queue_type *queue, node_type *node) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(node != NULL); \
+		pthread_mutex_lock(&queue->lock); \
+		CONCAT(function_prefix, lpushback)(&queue->list, node); \
+		CONCAT(fiber_prefix, wwake)(&queue->waiters); \
+		pthread_mutex_unlock(&queue->lock); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, fqpop)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		pthread_mutex_lock(&queue->lock); \
+		while (queue->list.n == 0) { \
+			CONCAT(fiber_prefix, wpark)(&queue->waiters, &queue->lock); \
+		} \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&queue->list); \
+		pthread_mutex_unlock(&queue->lock); \
+		return node; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, fqtrypop)(queue_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		pthread_mutex_lock(&queue->lock); \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&queue->list); \
+		pthread_mutex_unlock(&queue->lock); \
+		return node; \
+	} /*}}}*/
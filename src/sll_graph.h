@@ -0,0 +1,450 @@
+#pragma once
+
+/*
+ * adjacency list graph store on top of the singly linked lists from sll_meta.h
+ *
+ * given an edge type on the form
+ *
+ * struct myedge {
+ * 	SLL_LINK(myedge);
+ * 	SLL_GRAPH_LINK;
+ * 	...
+ * } myedge;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, myedge, myedgelist);
+ * SLL_POOL_DECLS(mysll, myedge, myedgelist, myedgepool);
+ * SLL_GRAPH_DECLS(mysll, myedge, myedgelist, myedgepool, mygraph);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, myedge, myedgelist, (void));
+ * SLL_POOL_DEFS(mysll, myedge, myedgelist, myedgepool);
+ * SLL_GRAPH_DEFS(mysll, myedge, myedgelist, myedgepool, mygraph);
+ *
+ * where source stuff is appropriate, you get a directed graph type mygraph over the vertices
+ * 0..n-1, where the outgoing edges of every vertex are chained through sll_link_next. Edges are
+ * carved out of slabs of SLL_GRAPH_SLAB edges, and removed edges are kept in the graph's edge
+ * pool for reuse, so building and mutating the graph does not call malloc per edge. As the edges
+ * belong to the slabs, the node free function given to SLL_DEFS must do nothing, as (void) does,
+ * and gfree is the only way to release them.
+ *
+ * For read heavy phases the graph can be frozen, which copies the adjacency lists into CSR arrays
+ * (offsets[n+1] and targets[m]) that traversals use instead of chasing edge pointers. The lists
+ * are kept, so any mutation simply drops the frozen arrays again.
+ *
+ * Breadth first search runs level by level on a pool of workers that gstart creates once, together
+ * with the calling thread, and reuses its frontier arrays across searches, so repeated searches
+ * neither create threads nor allocate unless the graph has grown.
+ *
+ * bool    mysll_ginit(mygraph *graph, size_t n)             // initializes a graph with n vertices and no edges, false on failure
+ * bool    mysll_gresize(mygraph *graph, size_t n)           // grows the graph to n vertices, false on failure
+ * size_t  mysll_gvsize(const mygraph *graph)                // returns the number of vertices
+ * size_t  mysll_gesize(const mygraph *graph)                // returns the number of edges
+ * myedge *mysll_gedge(mygraph *graph, size_t from, size_t to)
+ *                                                           // adds an edge and returns it for the caller to fill in (or NULL)
+ * size_t  mysll_gremove(mygraph *graph, size_t from, size_t to)
+ *                                                           // removes all edges from -> to, returns how many
+ * const myedgelist *mysll_gout(const mygraph *graph, size_t v)
+ *                                                           // returns the list of edges going out from v
+ * bool    mysll_gfreeze(mygraph *graph)                     // builds the CSR arrays, false on failure
+ * bool    mysll_gisfrozen(const mygraph *graph)             // returns true if the CSR arrays are current
+ * int     mysll_gstart(mygraph *graph, size_t nthreads)     // starts workers so that searches run on nthreads threads, the
+ *                                                           // calling one included, returns 0 or an error number
+ * void    mysll_gstop(mygraph *graph)                       // stops and joins the workers, not while a search is going on
+ * size_t  mysll_gbfs(mygraph *graph, size_t source, size_t *dist)
+ *                                                           // breadth first search from source, sets dist[v] to the hop
+ *                                                           // count from source, or SIZE_MAX if v is not reachable, returns
+ *                                                           // the number of reached vertices (0 on failure)
+ * void    mysll_gfree(mygraph *graph)                       // stops the workers, releases all edges, slabs and arrays
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+#ifndef SLL_GRAPH_SLAB
+#define SLL_GRAPH_SLAB 4096
+#endif
+
+#ifndef SLL_GRAPH_BFS_CHUNK
+#define SLL_GRAPH_BFS_CHUNK 256
+#endif
+
+// in-type data addition
+#define SLL_GRAPH_LINK size_t sll_graph_to
+
+// header declarations
+#define SLL_GRAPH_DECLS(function_prefix, node_type, list_type, pool_type, graph_type) \
+	typedef struct CONCAT(graph_type, slab) { /*{{{*/ \
+		SLL_LINK(CONCAT(graph_type, slab)); \
+		size_t used; \
+		node_type edges[]; \
+	} CONCAT(graph_type, slab); /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, gs), CONCAT(graph_type, slab), CONCAT(graph_type, slablist)); \
+	typedef struct { /*{{{*/ \
+		struct graph_type *graph; \
+		size_t index; \
+		pthread_t thread; \
+	} CONCAT(graph_type, bfsworker); /*}}}*/ \
+	typedef struct { /*{{{*/ \
+		size_t *dist; \
+		size_t *frontier; \
+		size_t *next; \
+		size_t capacity; \
+		size_t nfrontier; \
+		atomic_size_t nnext; \
+		atomic_size_t cursor; \
+		atomic_size_t reached; \
+		size_t level; \
+		CONCAT(graph_type, bfsworker) *workers; \
+		size_t nworkers; \
+		pthread_mutex_t lock; \
+		pthread_cond_t start; \
+		pthread_cond_t done; \
+		pthread_barrier_t barrier; \
+		size_t generation; \
+		size_t active; \
+		bool stopping; \
+	} CONCAT(graph_type, bfs); /*}}}*/ \
+	typedef struct graph_type { /*{{{*/ \
+		list_type *adj; \
+		size_t nvertices; \
+		size_t nedges; \
+		pool_type pool; \
+		CONCAT(graph_type, slablist) slabs; \
+		size_t *offsets; \
+		size_t *targets; \
+		CONCAT(graph_type, bfs) bfs; \
+	} graph_type; /*}}}*/ \
+	bool             CONCAT(function_prefix, ginit)    (graph_type *graph, size_t n); \
+	bool             CONCAT(function_prefix, gresize)  (graph_type *graph, size_t n); \
+	size_t           CONCAT(function_prefix, gvsize)   (const graph_type *graph); \
+	size_t           CONCAT(function_prefix, gesize)   (const graph_type *graph); \
+	node_type       *CONCAT(function_prefix, gedge)    (graph_type *graph, size_t from, size_t to); \
+	size_t           CONCAT(function_prefix, gremove)  (graph_type *graph, size_t from, size_t to); \
+	const list_type *CONCAT(function_prefix, gout)     (const graph_type *graph, size_t v); \
+	bool             CONCAT(function_prefix, gfreeze)  (graph_type *graph); \
+	bool             CONCAT(function_prefix, gisfrozen)(const graph_type *graph); \
+	int              CONCAT(function_prefix, gstart)   (graph_type *graph, size_t nthreads); \
+	void             CONCAT(function_prefix, gstop)    (graph_type *graph); \
+	size_t           CONCAT(function_prefix, gbfs)     (graph_type *graph, size_t source, size_t *dist); \
+	void             CONCAT(function_prefix, gfree)    (graph_type *graph)
+
+// definitions
+
+#define SLL_GRAPH_DEFS(function_prefix, node_type, list_type, pool_type, graph_type) \
+	SLL_DEFS(CONCAT(function_prefix, gs), CONCAT(graph_type, slab), CONCAT(graph_type, slablist), free) \
+	static void CONCAT(function_prefix, gdropcsr)(graph_type *graph) { /*{{{*/ \
+		free(graph->offsets); \
+		free(graph->targets); \
+		graph->offsets = NULL; \
+		graph->targets = NULL; \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, gbfsflush)(CONCAT(graph_type, bfs) *bfs, size_t *buf, size_t n) { /*{{{*/ \
+		size_t at = atomic_fetch_add_explicit(&bfs->nnext, n, memory_order_relaxed); \
+		for (size_t i=0; i<n; ++i) { bfs->next[at + i] = buf[i]; } \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, gbfsvisit)(CONCAT(graph_type, bfs) *bfs, size_t to, size_t *buf, size_t *nbuf) { /*{{{*/ \
+		size_t unseen = SIZE_MAX; \
+		if (__atomic_load_n(&bfs->dist[to], __ATOMIC_RELAXED) != SIZE_MAX) { return; } \
+		if (!__atomic_compare_exchange_n(&bfs->dist[to], &unseen, bfs->level + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { return; } \
+		buf[(*nbuf)++] = to; \
+		if (*nbuf == SLL_GRAPH_BFS_CHUNK) { \
+			CONCAT(function_prefix, gbfsflush)(bfs, buf, *nbuf); \
+			*nbuf = 0; \
+		} \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, gbfslevels)(CONCAT(graph_type, bfsworker) *worker) { /*{{{*/ \
+		/* one search, the barrier has a seat for every worker and the calling thread */ \
+		const graph_type *graph = worker->graph; \
+		CONCAT(graph_type, bfs) *bfs = &worker->graph->bfs; \
+		size_t buf[SLL_GRAPH_BFS_CHUNK]; \
+		for (;;) { \
+			pthread_barrier_wait(&bfs->barrier); \
+			if (bfs->nfrontier == 0) { break; } \
+			size_t nbuf = 0; \
+			size_t lo; \
+			while ((lo = atomic_fetch_add_explicit(&bfs->cursor, SLL_GRAPH_BFS_CHUNK, memory_order_relaxed)) < bfs->nfrontier) { \
+				size_t hi = lo + SLL_GRAPH_BFS_CHUNK < bfs->nfrontier ? lo + SLL_GRAPH_BFS_CHUNK : bfs->nfrontier; \
+				for (size_t i=lo; i<hi; ++i) { \
+					size_t v = bfs->frontier[i]; \
+					if (graph->offsets != NULL) { \
+						for (size_t e=graph->offsets[v]; e<graph->offsets[v+1]; ++e) { \
+							CONCAT(function_prefix, gbfsvisit)(bfs, graph->targets[e], buf, &nbuf); \
+						} \
+					} \
+					else { \
+						for (const node_type *edge=graph->adj[v].first; edge != NULL; edge=SLL_NEXT(edge)) { \
+							CONCAT(function_prefix, gbfsvisit)(bfs, edge->sll_graph_to, buf, &nbuf); \
+						} \
+					} \
+				} \
+			} \
+			if (nbuf > 0) { CONCAT(function_prefix, gbfsflush)(bfs, buf, nbuf); } \
+			pthread_barrier_wait(&bfs->barrier); \
+			if (worker->index == 0) { \
+				size_t *swap = bfs->frontier; \
+				bfs->frontier = bfs->next; \
+				bfs->next = swap; \
+				bfs->nfrontier = atomic_load(&bfs->nnext); \
+				atomic_fetch_add(&bfs->reached, bfs->nfrontier); \
+				atomic_store(&bfs->nnext, 0); \
+				atomic_store(&bfs->cursor, 0); \
+				++bfs->level; \
+			} \
+		} \
+	} /*}}}*/ \
+	static void *CONCAT(function_prefix, gbfsworker)(void *p) { /*{{{*/ \
+		CONCAT(graph_type, bfsworker) *worker = p; \
+		CONCAT(graph_type, bfs) *bfs = &worker->graph->bfs; \
+		size_t seen = 0; \
+		pthread_mutex_lock(&bfs->lock); \
+		for (;;) { \
+			while (bfs->generation == seen && !bfs->stopping) { \
+				pthread_cond_wait(&bfs->start, &bfs->lock); \
+			} \
+			if (bfs->stopping) { break; } \
+			seen = bfs->generation; \
+			pthread_mutex_unlock(&bfs->lock); \
+			CONCAT(function_prefix, gbfslevels)(worker); \
+			pthread_mutex_lock(&bfs->lock); \
+			/* the next search must not reset the frontier while we may still look at it */ \
+			assert(bfs->active > 0); \
+			if (--bfs->active == 0) { pthread_cond_signal(&bfs->done); } \
+		} \
+		pthread_mutex_unlock(&bfs->lock); \
+		return NULL; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, ginit)(graph_type *graph, size_t n) { /*{{{*/ \
+		assert(graph != NULL); \
+		graph->adj = NULL; \
+		graph->nvertices = 0; \
+		graph->nedges = 0; \
+		graph->offsets = NULL; \
+		graph->targets = NULL; \
+		CONCAT(function_prefix, pclear)(&graph->pool); \
+		CONCAT(CONCAT(function_prefix, gs), lclear)(&graph->slabs); \
+		CONCAT(graph_type, bfs) *bfs = &graph->bfs; \
+		bfs->frontier = NULL; \
+		bfs->next = NULL; \
+		bfs->capacity = 0; \
+		bfs->workers = NULL; \
+		bfs->nworkers = 0; \
+		bfs->generation = 0; \
+		bfs->active = 0; \
+		bfs->stopping = false; \
+		pthread_mutex_init(&bfs->lock, NULL); \
+		pthread_cond_init(&bfs->start, NULL); \
+		pthread_cond_init(&bfs->done, NULL); \
+		pthread_barrier_init(&bfs->barrier, NULL, 1); \
+		return CONCAT(function_prefix, gresize)(graph, n); \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, gresize)(graph_type *graph, size_t n) { /*{{{*/ \
+		assert(graph != NULL); \
+		if (n <= graph->nvertices) { return true; } \
+		list_type *adj = realloc(graph->adj, n * sizeof(list_type)); \
+		if (adj == NULL) { return false; } \
+		for (size_t v=graph->nvertices; v<n; ++v) { \
+			CONCAT(function_prefix, lclear)(&adj[v]); \
+		} \
+		graph->adj = adj; \
+		graph->nvertices = n; \
+		CONCAT(function_prefix, gdropcsr)(graph); \
+		return true; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, gvsize)(const graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		return graph->nvertices; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, gesize)(const graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		return graph->nedges; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, gedge)(graph_type *graph, size_t from, size_t to) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(from < graph->nvertices); \
+		assert(to < graph->nvertices); \
+		node_type *edge; \
+		CONCAT(graph_type, slab) *slab = graph->slabs.last; \
+		if (graph->pool.n > 0) { \
+			edge = CONCAT(function_prefix, pget)(&graph->pool); \
+		} \
+		else { \
+			if (slab == NULL || slab->used == SLL_GRAPH_SLAB) { \
+				slab = malloc(sizeof(CONCAT(graph_type, slab)) + SLL_GRAPH_SLAB * sizeof(node_type)); \
+				if (slab == NULL) { return NULL; } \
+				slab->used = 0; \
+				CONCAT(CONCAT(function_prefix, gs), lpushback)(&graph->slabs, slab); \
+			} \
+			edge = &slab->edges[slab->used++]; \
+			edge->sll_link_next = NULL; /* no tags */ \
+		} \
+		edge->sll_graph_to = to; \
+		CONCAT(function_prefix, lpushback)(&graph->adj[from], edge); \
+		++graph->nedges; \
+		CONCAT(function_prefix, gdropcsr)(graph); \
+		return edge; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, gremove)(graph_type *graph, size_t from, size_t to) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(from < graph->nvertices); \
+		list_type *list = &graph->adj[from]; \
+		list_type kept; \
+		size_t removed = 0; \
+		CONCAT(function_prefix, lclear)(&kept); \
+		node_type *edge; \
+		while ((edge = CONCAT(function_prefix, lpopfront)(list)) != NULL) { \
+			if (edge->sll_graph_to == to) { \
+				CONCAT(function_prefix, preturn)(&graph->pool, edge); \
+				++removed; \
+			} \
+			else { \
+				CONCAT(function_prefix, lpushback)(&kept, edge); \
+			} \
+		} \
+		*list = kept; \
+		graph->nedges -= removed; \
+		if (removed > 0) { CONCAT(function_prefix, gdropcsr)(graph); } \
+		return removed; \
+	} /*}}}*/ \
+	const list_type *CONCAT(function_prefix, gout)(const graph_type *graph, size_t v) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(v < graph->nvertices); \
+		return &graph->adj[v]; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, gfreeze)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		if (graph->offsets != NULL) { return true; } \
+		size_t *offsets = malloc((graph->nvertices + 1) * sizeof(size_t)); \
+		size_t *targets = malloc((graph->nedges > 0 ? graph->nedges : 1) * sizeof(size_t)); \
+		if (offsets == NULL || targets == NULL) { \
+			free(offsets); \
+			free(targets); \
+			return false; \
+		} \
+		size_t at = 0; \
+		for (size_t v=0; v<graph->nvertices; ++v) { \
+			offsets[v] = at; \
+			for (const node_type *edge=graph->adj[v].first; edge != NULL; edge=SLL_NEXT(edge)) { \
+				targets[at++] = edge->sll_graph_to; \
+			} \
+		} \
+		offsets[graph->nvertices] = at; \
+		graph->offsets = offsets; \
+		graph->targets = targets; \
+		return true; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, gisfrozen)(const graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		return graph->offsets != NULL; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, gstart)(graph_type *graph, size_t nthreads) { /*{{{*/ \
+		assert(graph != NULL); \
+		CONCAT(graph_type, bfs) *bfs = &graph->bfs; \
+		assert(bfs->nworkers == 0); \
+		if (nthreads <= 1) { return 0; } \
+		/* slot 0 is the thread calling gbfs */ \
+		bfs->workers = calloc(nthreads, sizeof(CONCAT(graph_type, bfsworker))); \
+		if (bfs->workers == NULL) { return ENOMEM; } \
+		pthread_barrier_destroy(&bfs->barrier); \
+		pthread_barrier_init(&bfs->barrier, NULL, (unsigned)nthreads); \
+		bfs->stopping = false; \
+		for (size_t i=0; i<nthreads; ++i) { \
+			bfs->workers[i].graph = graph; \
+			bfs->workers[i].index = i; \
+		} \
+		for (bfs->nworkers=1; bfs->nworkers<nthreads; ++bfs->nworkers) { \
+			CONCAT(graph_type, bfsworker) *worker = &bfs->workers[bfs->nworkers]; \
+			int ret = pthread_create(&worker->thread, NULL, CONCAT(function_prefix, gbfsworker), worker); \
+			if (ret != 0) { \
+				CONCAT(function_prefix, gstop)(graph); \
+				return ret; \
+			} \
+		} \
+		return 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, gstop)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		CONCAT(graph_type, bfs) *bfs = &graph->bfs; \
+		if (bfs->workers == NULL) { return; } \
+		pthread_mutex_lock(&bfs->lock); \
+		bfs->stopping = true; \
+		pthread_cond_broadcast(&bfs->start); \
+		pthread_mutex_unlock(&bfs->lock); \
+		for (size_t i=1; i<bfs->nworkers; ++i) { \
+			pthread_join(bfs->workers[i].thread, NULL); \
+		} \
+		/* workers of a later gstart count searches from 0 again */ \
+		bfs->generation = 0; \
+		free(bfs->workers); \
+		bfs->workers = NULL; \
+		bfs->nworkers = 0; \
+		pthread_barrier_destroy(&bfs->barrier); \
+		pthread_barrier_init(&bfs->barrier, NULL, 1); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, gbfs)(graph_type *graph, size_t source, size_t *dist) { /*{{{*/ \
+		assert(graph != NULL); \
+		assert(source < graph->nvertices); \
+		assert(dist != NULL); \
+		CONCAT(graph_type, bfs) *bfs = &graph->bfs; \
+		if (bfs->capacity < graph->nvertices) { \
+			size_t *frontier = realloc(bfs->frontier, graph->nvertices * sizeof(size_t)); \
+			if (frontier != NULL) { bfs->frontier = frontier; } \
+			size_t *next = realloc(bfs->next, graph->nvertices * sizeof(size_t)); \
+			if (next != NULL) { bfs->next = next; } \
+			if (frontier == NULL || next == NULL) { return 0; } \
+			bfs->capacity = graph->nvertices; \
+		} \
+		for (size_t v=0; v<graph->nvertices; ++v) { dist[v] = SIZE_MAX; } \
+		dist[source] = 0; \
+		bfs->dist = dist; \
+		bfs->frontier[0] = source; \
+		bfs->nfrontier = 1; \
+		bfs->level = 0; \
+		atomic_store(&bfs->nnext, 0); \
+		atomic_store(&bfs->cursor, 0); \
+		atomic_store(&bfs->reached, 1); \
+		CONCAT(graph_type, bfsworker) self = { .graph = graph, .index = 0 }; \
+		if (bfs->nworkers > 1) { \
+			pthread_mutex_lock(&bfs->lock); \
+			bfs->active = bfs->nworkers - 1; \
+			++bfs->generation; \
+			pthread_cond_broadcast(&bfs->start); \
+			pthread_mutex_unlock(&bfs->lock); \
+		} \
+		CONCAT(function_prefix, gbfslevels)(&self); \
+		if (bfs->nworkers > 1) { \
+			pthread_mutex_lock(&bfs->lock); \
+			while (bfs->active > 0) { pthread_cond_wait(&bfs->done, &bfs->lock); } \
+			pthread_mutex_unlock(&bfs->lock); \
+		} \
+		return atomic_load(&bfs->reached); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, gfree)(graph_type *graph) { /*{{{*/ \
+		assert(graph != NULL); \
+		CONCAT(function_prefix, gstop)(graph); \
+		CONCAT(function_prefix, gdropcsr)(graph); \
+		/* edges live in the slabs, so the pool is only forgotten, not freed */ \
+		CONCAT(function_prefix, pclear)(&graph->pool); \
+		CONCAT(CONCAT(function_prefix, gs), lfree)(&graph->slabs); \
+		free(graph->adj); \
+		graph->adj = NULL; \
+		graph->nvertices = 0; \
+		graph->nedges = 0; \
+		free(graph->bfs.frontier); \
+		free(graph->bfs.next); \
+		graph->bfs.frontier = NULL; \
+		graph->bfs.next = NULL; \
+		graph->bfs.capacity = 0; \
+		pthread_barrier_destroy(&graph->bfs.barrier); \
+		pthread_cond_destroy(&graph->bfs.done); \
+		pthread_cond_destroy(&graph->bfs.start); \
+		pthread_mutex_destroy(&graph->bfs.lock); \
+	} /*}}}*/
@@ -0,0 +1,158 @@
+#pragma once
+
+/*
+ * zero copy record ingestion from memory mapped files into lists of pooled nodes from sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_INGEST_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_POOL_DECLS(mysll, mynode, mylist, mypool);
+ * SLL_INGEST_DECLS(mysll, mynode, mylist, mypool, mymapping);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_POOL_DEFS(mysll, mynode, mylist, mypool);
+ * SLL_INGEST_DEFS(mysll, mynode, mylist, mypool, mymapping);
+ *
+ * where source stuff is appropriate, you get a mapping type mymapping for a read only, sequentially
+ * accessed (MADV_SEQUENTIAL, and MADV_HUGEPAGE where the kernel supports it for files) memory
+ * mapping of an input file, and functions that parse records out of it into nodes from the pool.
+ * The nodes do not get a copy of their record, but node->sll_ingest_data and node->sll_ingest_len
+ * referencing the record inside the mapping, so they are only valid until the mapping is unmapped.
+ *
+ * int     mysll_inmap(mymapping *map, const char *path)  // maps the file at path, returns 0 or an error number
+ * void    mysll_inunmap(mymapping *map)                  // unmaps the file, invalidating all record references
+ * size_t  mysll_insplit(mymapping *map, mypool *pool, mylist *list, char delim)
+ *                                                        // appends a node for every delim terminated record (the last
+ *                                                        // one may be unterminated) to list, returns how many
+ * size_t  mysll_inframes(mymapping *map, mypool *pool, mylist *list, size_t prefix)
+ *                                                        // appends a node for every record preceded by a big endian
+ *                                                        // length of prefix (1, 2, 4 or 8) bytes, returns how many
+ * size_t  mysll_inleft(const mymapping *map)             // returns the number of bytes not parsed into records, e.g.
+ *                                                        // a truncated last frame or records skipped for lack of nodes
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sll_meta.h"
+
+// in-type data addition
+#define SLL_INGEST_LINK \
+	const char *sll_ingest_data; \
+	size_t sll_ingest_len
+
+// header declarations
+#define SLL_INGEST_DECLS(function_prefix, node_type, list_type, pool_type, mapping_type) \
+	typedef struct { /*{{{*/ \
+		const char *data; \
+		size_t size; \
+		size_t offset; \
+	} mapping_type; /*}}}*/ \
+	int    CONCAT(function_prefix, inmap)   (mapping_type *map, const char *path); \
+	void   CONCAT(function_prefix, inunmap) (mapping_type *map); \
+	size_t CONCAT(function_prefix, insplit) (mapping_type *map, pool_type *pool, list_type *list, char delim); \
+	size_t CONCAT(function_prefix, inframes)(mapping_type *map, pool_type *pool, list_type *list, size_t prefix); \
+	size_t CONCAT(function_prefix, inleft)  (const mapping_type *map)
+
+// definitions
+
+#define SLL_INGEST_DEFS(function_prefix, node_type, list_type, pool_type, mapping_type) \
+	static bool CONCAT(function_prefix, inrecord)(pool_type *pool, list_type *list, const char *data, size_t len) { /*{{{*/ \
+		node_type *node = CONCAT(function_prefix, pget)(pool); \
+		if (node == NULL) { return false; } \
+		node->sll_ingest_data = data; \
+		node->sll_ingest_len = len; \
+		CONCAT(function_prefix, lpushback)(list, node); \
+		return true; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, inmap)(mapping_type *map, const char *path) { /*{{{*/ \
+		assert(map != NULL); \
+		assert(path != NULL); \
+		struct stat st; \
+		map->data = NULL; \
+		map->size = 0; \
+		map->offset = 0; \
+		int fd = open(path, O_RDONLY | O_CLOEXEC); \
+		if (fd < 0) { return errno; } \
+		if (fstat(fd, &st) < 0) { \
+			int err = errno; \
+			close(fd); \
+			return err; \
+		} \
+		if (st.st_size == 0) { \
+			close(fd); \
+			return 0; \
+		} \
+		void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0); \
+		int err = errno; \
+		close(fd); \
+		if (data == MAP_FAILED) { return err; } \
+		/* both are hints only, so failures are not errors */ \
+		madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL); \
+		madvise(data, (size_t)st.st_size, MADV_HUGEPAGE); \
+		map->data = data; \
+		map->size = (size_t)st.st_size; \
+		return 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, inunmap)(mapping_type *map) { /*{{{*/ \
+		assert(map != NULL); \
+		if (map->data != NULL) { \
+			munmap((void *)(uintptr_t)map->data, map->size); \
+		} \
+		map->data = NULL; \
+		map->size = 0; \
+		map->offset = 0; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, insplit)(mapping_type *map, pool_type *pool, list_type *list, char delim) { /*{{{*/ \
+		assert(map != NULL); \
+		assert(pool != NULL); \
+		assert(list != NULL); \
+		size_t n = 0; \
+		while (map->offset < map->size) { \
+			const char *start = map->data + map->offset; \
+			size_t left = map->size - map->offset; \
+			const char *end = memchr(start, delim, left); \
+			size_t len = end != NULL ? (size_t)(end - start) : left; \
+			if (!CONCAT(function_prefix, inrecord)(pool, list, start, len)) { break; } \
+			map->offset += end != NULL ? len + 1 : len; \
+			++n; \
+		} \
+		return n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, inframes)(mapping_type *map, pool_type *pool, list_type *list, size_t prefix) { /*{{{*/ \
+		assert(map != NULL); \
+		assert(pool != NULL); \
+		assert(list != NULL); \
+		assert(prefix == 1 || prefix == 2 || prefix == 4 || prefix == 8); \
+		size_t n = 0; \
+		while (map->size - map->offset >= prefix) { \
+			const unsigned char *p = (const unsigned char *)map->data + map->offset; \
+			uint64_t len = 0; \
+			for (size_t i=0; i<prefix; ++i) { len = len << 8 | p[i]; } \
+			if (len > map->size - map->offset - prefix) { break; } \
+			if (!CONCAT(function_prefix, inrecord)(pool, list, map->data + map->offset + prefix, (size_t)len)) { break; } \
+			map->offset += prefix + (size_t)len; \
+			++n; \
+		} \
+		return n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, inleft)(const mapping_type *map) { /*{{{*/ \
+		assert(map != NULL); \
+		return map->size - map->offset; \
+	} /*}}}*/
@@ -0,0 +1,177 @@
+#pragma once
+
+/*
+ * thread safe lists with atomic moves between them, on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_LOCKED_DECLS(mysll, mynode, mylist, mylocked);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_LOCKED_DEFS(mysll, mynode, mylist, mylocked);
+ *
+ * where source stuff is appropriate, gives you a list type mylocked guarded by a lock of its own,
+ * and moves of a node or a set of nodes from one such list to another that hold the locks of both
+ * lists at once, so that no other thread ever sees a moved node on neither or on both lists. The
+ * two locks are always taken in address order, so concurrent moves in opposite directions, or around
+ * a cycle of lists, cannot deadlock, and moves between unrelated lists do not serialize each other.
+ *
+ * bool    mysll_lkinit(mylocked *list)                 // initializes an empty list, false on failure
+ * void    mysll_lkdestroy(mylocked *list)              // releases the lock, nodes still on the list are left alone
+ * void    mysll_lkpush(mylocked *list, mynode *node)   // appends node
+ * mynode *mysll_lkpop(mylocked *list)                  // removes and returns the first node (or NULL)
+ * size_t  mysll_lksize(mylocked *list)                 // returns the number of nodes on the list
+ * bool    mysll_lkmove(mylocked *src, mylocked *dst, mynode *node)
+ *                                                      // moves node from src to the end of dst, false if it was not on src
+ * mynode *mysll_lkmovefirst(mylocked *src, mylocked *dst)
+ *                                                      // moves the first node of src to the end of dst and returns it
+ *                                                      // (or NULL if src was empty)
+ * size_t  mysll_lkmoveif(mylocked *src, mylocked *dst, bool (*pred)(const mynode *node, void *arg), void *arg)
+ *                                                      // moves all nodes of src for which pred is true to the end of
+ *                                                      // dst, in order and as one step, returns how many
+ * size_t  mysll_lkmoveall(mylocked *src, mylocked *dst)
+ *                                                      // splices all of src onto the end of dst, returns how many
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+// header declarations
+#define SLL_LOCKED_DECLS(function_prefix, node_type, list_type, locked_type) \
+	typedef struct { /*{{{*/ \
+		pthread_mutex_t lock; \
+		list_type list; \
+	} locked_type; /*}}}*/ \
+	bool       CONCAT(function_prefix, lkinit)     (locked_type *list); \
+	void       CONCAT(function_prefix, lkdestroy)  (locked_type *list); \
+	void       CONCAT(function_prefix, lkpush)     (locked_type *list, node_type *node); \
+	node_type *CONCAT(function_prefix, lkpop)      (locked_type *list); \
+	size_t     CONCAT(function_prefix, lksize)     (locked_type *list); \
+	bool       CONCAT(function_prefix, lkmove)     (locked_type *src, locked_type *dst, node_type *node); \
+	node_type *CONCAT(function_prefix, lkmovefirst)(locked_type *src, locked_type *dst); \
+	size_t     CONCAT(function_prefix, lkmoveif)   (locked_type *src, locked_type *dst, bool (*pred)(const node_type *node, void *arg), void *arg); \
+	size_t     CONCAT(function_prefix, lkmoveall)  (locked_type *src, locked_type *dst)
+
+// definitions
+
+#define SLL_LOCKED_DEFS(function_prefix, node_type, list_type, locked_type) \
+	static void CONCAT(function_prefix, lklock2)(locked_type *a, locked_type *b) { /*{{{*/ \
+		if (a == b) { \
+			pthread_mutex_lock(&a->lock); \
+			return; \
+		} \
+		if ((uintptr_t)a > (uintptr_t)b) { \
+			locked_type *t = a; \
+			a = b; \
+			b = t; \
+		} \
+		pthread_mutex_lock(&a->lock); \
+		pthread_mutex_lock(&b->lock); \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, lkunlock2)(locked_type *a, locked_type *b) { /*{{{*/ \
+		pthread_mutex_unlock(&a->lock); \
+		if (a != b) { pthread_mutex_unlock(&b->lock); } \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, lkunlink)(list_type *list, node_type *prev, node_type *node) { /*{{{*/ \
+		if (prev == NULL) { list->first = SLL_NEXT(node); } \
+		else { SLL_SETNEXT(prev, SLL_NEXT(node)); } \
+		if (list->last == node) { list->last = prev; } \
+		--list->n; \
+		SLL_LNCLEAR(node); \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, lkinit)(locked_type *list) { /*{{{*/ \
+		assert(list != NULL); \
+		if (pthread_mutex_init(&list->lock, NULL) != 0) { return false; } \
+		CONCAT(function_prefix, lclear)(&list->list); \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, lkdestroy)(locked_type *list) { /*{{{*/ \
+		assert(list != NULL); \
+		pthread_mutex_destroy(&list->lock); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, lkpush)(locked_type *list, node_type *node) { /*{{{*/ \
+		assert(list != NULL); \
+		assert(node != NULL); \
+		pthread_mutex_lock(&list->lock); \
+		CONCAT(function_prefix, lpushback)(&list->list, node); \
+		pthread_mutex_unlock(&list->lock); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, lkpop)(locked_type *list) { /*{{{*/ \
+		assert(list != NULL); \
+		pthread_mutex_lock(&list->lock); \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&list->list); \
+		pthread_mutex_unlock(&list->lock); \
+		return node; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, lksize)(locked_type *list) { /*{{{*/ \
+		assert(list != NULL); \
+		pthread_mutex_lock(&list->lock); \
+		size_t n = list->list.n; \
+		pthread_mutex_unlock(&list->lock); \
+		return n; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, lkmove)(locked_type *src, locked_type *dst, node_type *node) { /*{{{*/ \
+		assert(src != NULL); \
+		assert(dst != NULL); \
+		assert(node != NULL); \
+		bool found = false; \
+		CONCAT(function_prefix, lklock2)(src, dst); \
+		for (node_type *prev = NULL, *cur = src->list.first; cur != NULL; prev = cur, cur = SLL_NEXT(cur)) { \
+			if (cur == node) { \
+				CONCAT(function_prefix, lkunlink)(&src->list, prev, node); \
+				CONCAT(function_prefix, lpushback)(&dst->list, node); \
+				found = true; \
+				break; \
+			} \
+		} \
+		CONCAT(function_prefix, lkunlock2)(src, dst); \
+		return found; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, lkmovefirst)(locked_type *src, locked_type *dst) { /*{{{*/ \
+		assert(src != NULL); \
+		assert(dst != NULL); \
+		CONCAT(function_prefix, lklock2)(src, dst); \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&src->list); \
+		if (node != NULL) { CONCAT(function_prefix, lpushback)(&dst->list, node); } \
+		CONCAT(function_prefix, lkunlock2)(src, dst); \
+		return node; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, lkmoveif)(locked_type *src, locked_type *dst, bool (*pred)(const node_type *node, void *arg), void *arg) { /*{{{*/ \
+		assert(src != NULL); \
+		assert(dst != NULL); \
+		assert(pred != NULL); \
+		list_type moved; \
+		CONCAT(function_prefix, lclear)(&moved); \
+		CONCAT(function_prefix, lklock2)(src, dst); \
+		node_type *prev = NULL, *cur = src->list.first; \
+		while (cur != NULL) { \
+			node_type *next = SLL_NEXT(cur); \
+			if (pred(cur, arg)) { \
+				CONCAT(function_prefix, lkunlink)(&src->list, prev, cur); \
+				CONCAT(function_prefix, lpushback)(&moved, cur); \
+			} \
+			else { \
+				prev = cur; \
+			} \
+			cur = next; \
+		} \
+		size_t n = moved.n; \
+		CONCAT(function_prefix, lsplice)(&dst->list, &moved); \
+		CONCAT(function_prefix, lkunlock2)(src, dst); \
+		return n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, lkmoveall)(locked_type *src, locked_type *dst) { /*{{{*/ \
+		assert(src != NULL); \
+		assert(dst != NULL); \
+		if (src == dst) { return CONCAT(function_prefix, lksize)(src); } \
+		CONCAT(function_prefix, lklock2)(src, dst); \
+		size_t n = src->list.n; \
+		CONCAT(function_prefix, lsplice)(&dst->list, &src->list); \
+		CONCAT(function_prefix, lkunlock2)(src, dst); \
+		return n; \
+	} /*}}}*/
@@ -32,7 +32,15 @@
  * size_t  mysll_lsize(const mylist *list)             // returns the number of elements in the list
  * void    mysll_lpushback(mylist *list, mynode *node) // appends a mynode element to the list
  * mynode *mysll_lpopfront(mylist *list)               // removes and returns the first element of the list (or NULL)
+ * void    mysll_lsplice(mylist *dst, mylist *src)     // moves all elements of src to the end of dst in O(1), leaving src empty
+ * size_t  mysll_lfreeze(const mylist *list, mynode **nodes)
+ *                                                     // stores pointers to the elements of the list, in order, in nodes,
+ *                                                     // which must have room for lsize(list) pointers, returns the count
+ * void    mysll_lthaw(mylist *list, mynode *const *nodes, size_t n)
+ *                                                     // overwrites list with the n nodes of the array, linked in order
  * void    mysll_lfree(mylist *list)                   // empties the list and calls nodefree on all nodes
+ * unsigned mysll_ltags(const mynode *node)            // returns the tag bits of a node (see TAGGED LINKS)
+ * void    mysll_lsettags(mynode *node, unsigned tags) // sets the tag bits of a node, leaving its link alone
  *
  * ITERATOR FUNCTIONS
  *
@@ -47,6 +55,44 @@
  * You can also make use of the macro SLL_ITER_START, as in "someiter it = SLL_ITER_START(&somelist)" to statically initialize
  * an iterator e.g. in the initialization field of a for loop.
  *
+ * TAGGED LINKS
+ *
+ * Defining SLL_TAG_BITS to 1, 2 or 3 before including this header packs as many flag bits per node into the low bits of
+ * sll_link_next, which are always zero for nodes aligned to at least 1 << SLL_TAG_BITS bytes (checked at compile time),
+ * so that flags like queued, dirty or visited need no field of their own. Every function here and in the headers built
+ * on top of this one masks the tags out of the link and keeps them when relinking a node, and ltags and lsettags get and
+ * set them. Code walking the links by hand must use SLL_NEXT(node) instead of node->sll_link_next then. The setting
+ * applies to all list types in a translation unit and defaults to 0, where the masking compiles away. All translation
+ * units sharing a list type must agree on it: SLL_DEFS defines a symbol mysll_tagbits_N for its setting N, SLL_DECLS
+ * references the one for the setting it sees, and a mismatch fails to link on it. Tags are plain
+ * node data: nodes pget allocates have no tags set, recycled nodes keep theirs, and nodes from malloc, pgetm or the
+ * slab pool have undefined tags until set.
+ *
+ * SLL_NEXT(node)                             // the next node, with the tags masked out
+ * SLL_SETNEXT(node, next)                    // links node to next, keeping the tags of node
+ *
+ * STATIC LISTS
+ *
+ * Nodes with static storage duration can be linked into a list entirely at compile time with the initializer macros
+ * below, so that the links, first, last and n are in the data segment of the binary and nothing runs at startup.
+ * Nodes may be linked across translation units, as the address of an extern node is a constant too. Such nodes are not
+ * heap allocated and must never reach nodefree or a pool, but the lists otherwise work as any other.
+ *
+ * SLL_STATIC_NODE(next, ...)                 // initializer for a node linked to next (or NULL), followed by
+ *                                            // designated initializers for the remaining fields
+ * SLL_STATIC_LIST(first, last, n)            // initializer for a list of the n nodes from first to last
+ * SLL_STATIC_ANODE(array, count, i, ...)     // initializer for element i of a node array of count elements,
+ *                                            // linked to element i+1 (or NULL for the last one)
+ * SLL_STATIC_ALIST(array, count)             // initializer for a list of all count elements of a node array
+ *
+ * as in
+ *
+ * static mynode handlers[2] = {
+ * 	SLL_STATIC_ANODE(handlers, 2, 0, .name="get"),
+ * 	SLL_STATIC_ANODE(handlers, 2, 1, .name="put"),
+ * };
+ * static mylist registry = SLL_STATIC_ALIST(handlers, 2);
+ *
  * MEMORY POOL FUNCTIONS
  *
  * If you make use of the SLL_POOL_DECLS and SLL_POOL_DEFLS with parameters (mysll, mynode, mylist, mypool) additionally, you get
@@ -56,12 +102,15 @@
  * mynode *mysll_pgetm(mypool *pool, bool *isnew)    // returns the first node in the pool or mallocs a new one iff the pool is empty
  *                                                   // isnew is set to true or false depending on whether a new node was allocated or not
  * void    mysll_preturn(mypool *pool, mynode *node) // puts the node back in the pool
+ * size_t  mysll_ptrim(mypool *pool, size_t keep)    // frees pooled nodes, longest pooled first, until keep are left,
+ *                                                   // returns how many were freed
  * void    mysll_pfree(mypool *pool)                 // empties the pool and frees memory
  *
  */
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdbool.h>
 
@@ -72,6 +121,14 @@
 #define CONCAT(a, b) CONCAT_(a, b)
 #endif
 
+#ifndef SLL_TAG_BITS
+#define SLL_TAG_BITS 0
+#endif
+
+_Static_assert(SLL_TAG_BITS >= 0 && SLL_TAG_BITS <= 3, "SLL_TAG_BITS must be 0 to 3");
+
+#define SLL_TAG_MASK (((uintptr_t)1 << SLL_TAG_BITS) - 1)
+
 // in-type data addition
 #define SLL_LINK(node_type) struct node_type *sll_link_next
 
@@ -87,7 +144,16 @@
 	size_t     CONCAT(function_prefix, lsize)    (const list_type *list); \
 	void       CONCAT(function_prefix, lpushback)(list_type *list, node_type *node); \
 	node_type *CONCAT(function_prefix, lpopfront)(list_type *list); \
-	void       CONCAT(function_prefix, lfree)    (list_type *list)
+	void       CONCAT(function_prefix, lsplice)  (list_type *dst, list_type *src); \
+	size_t     CONCAT(function_prefix, lfreeze)  (const list_type *list, node_type **nodes); \
+	void       CONCAT(function_prefix, lthaw)    (list_type *list, node_type *const *nodes, size_t n); \
+	void       CONCAT(function_prefix, lfree)    (list_type *list); \
+	unsigned   CONCAT(function_prefix, ltags)    (const node_type *node); \
+	void       CONCAT(function_prefix, lsettags) (node_type *node, unsigned tags); \
+	/* only defined by SLL_DEFS with the same SLL_TAG_BITS, so a mismatch fails to link */ \
+	extern const unsigned char CONCAT(function_prefix, CONCAT(tagbits, SLL_TAG_BITS)); \
+	__attribute__((used)) static const unsigned char *const CONCAT(function_prefix, tagcheck) = \
+		&CONCAT(function_prefix, CONCAT(tagbits, SLL_TAG_BITS))
 
 #define SLL_ITER_DECLS(function_prefix, node_type, list_type, iterator_type) \
 	typedef struct { /*{{{*/\
@@ -108,14 +174,24 @@
 	node_type  *CONCAT(function_prefix, pget)   (pool_type *pool); \
 	node_type  *CONCAT(function_prefix, pgetm)  (pool_type *pool, bool *isnew); \
 	void        CONCAT(function_prefix, preturn)(pool_type *pool, node_type *node); \
+	size_t      CONCAT(function_prefix, ptrim)  (pool_type *pool, size_t keep); \
 	void        CONCAT(function_prefix, pfree)  (pool_type *pool)
 
 // definitions
 
-#define SLL_ISTART(_list) { .list=(_list), .prev=NULL, .current=(_list)->first!=NULL?(_list)->first:NULL, .next=(_list)->first!=NULL?(_list)->first->sll_link_next:NULL }
-#define SLL_LNCLEAR(_NODE) do { _NODE->sll_link_next = NULL; } while (0);
+#define SLL_NEXT(_NODE) ((__typeof__(*(_NODE)->sll_link_next) *)((uintptr_t)(_NODE)->sll_link_next & ~SLL_TAG_MASK))
+#define SLL_SETNEXT(_NODE, _NEXT) do { (_NODE)->sll_link_next = (void *)((uintptr_t)(_NEXT) | ((uintptr_t)(_NODE)->sll_link_next & SLL_TAG_MASK)); } while (0)
+#define SLL_ISTART(_list) { .list=(_list), .prev=NULL, .current=(_list)->first!=NULL?(_list)->first:NULL, .next=(_list)->first!=NULL?SLL_NEXT((_list)->first):NULL }
+#define SLL_LNCLEAR(_NODE) do { SLL_SETNEXT(_NODE, NULL); } while (0);
+
+#define SLL_STATIC_NODE(_next, ...) { .sll_link_next=(_next), __VA_ARGS__ }
+#define SLL_STATIC_LIST(_first, _last, _n) { .first=(_first), .last=(_last), .n=(_n) }
+#define SLL_STATIC_ANODE(_array, _count, _i, ...) { .sll_link_next=(_i)+1<(_count)?&(_array)[(_i)+1]:NULL, __VA_ARGS__ }
+#define SLL_STATIC_ALIST(_array, _count) { .first=(_count)>0?&(_array)[0]:NULL, .last=(_count)>0?&(_array)[(_count)-1]:NULL, .n=(_count) }
 
 #define SLL_DEFS(function_prefix, node_type, list_type, node_free_func) \
+	_Static_assert(_Alignof(node_type) > SLL_TAG_MASK, "node type not aligned enough for SLL_TAG_BITS"); \
+	const unsigned char CONCAT(function_prefix, CONCAT(tagbits, SLL_TAG_BITS)) = SLL_TAG_BITS; \
 	void CONCAT(function_prefix, lclear)(list_type *list) { /*{{{*/ \
 		assert(list != NULL); \
 		list->first = NULL; \
@@ -138,7 +214,7 @@
 			list->n = 1; \
 		} \
 		else { \
-			list->last->sll_link_next = node; \
+			SLL_SETNEXT(list->last, node); \
 			list->last = node; \
 			++list->n; \
 		} \
@@ -148,17 +224,64 @@
 		assert(list != NULL); \
 		if (list->n == 0) { return NULL; } \
 		node_type *node = list->first; \
-		list->first = node->sll_link_next; \
+		list->first = SLL_NEXT(node); \
 		--list->n; \
 		if (list->first == NULL) { list->last = NULL; } \
 		SLL_LNCLEAR(node); \
 		return node; \
 	} /*}}}*/ \
+	void CONCAT(function_prefix, lsplice)(list_type *dst, list_type *src) { /*{{{*/ \
+		assert(dst != NULL); \
+		assert(src != NULL); \
+		if (src->n == 0) { return; } \
+		if (dst->n == 0) { \
+			dst->first = src->first; \
+		} \
+		else { \
+			SLL_SETNEXT(dst->last, src->first); \
+		} \
+		dst->last = src->last; \
+		dst->n += src->n; \
+		CONCAT(function_prefix, lclear)(src); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, lfreeze)(const list_type *list, node_type **nodes) { /*{{{*/ \
+		assert(list != NULL); \
+		assert(nodes != NULL || list->n == 0); \
+		size_t i = 0; \
+		for (node_type *node = list->first; node != NULL; node = SLL_NEXT(node)) { \
+			nodes[i++] = node; \
+		} \
+		return i; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, lthaw)(list_type *list, node_type *const *nodes, size_t n) { /*{{{*/ \
+		assert(list != NULL); \
+		assert(nodes != NULL || n == 0); \
+		if (n == 0) { \
+			CONCAT(function_prefix, lclear)(list); \
+			return; \
+		} \
+		for (size_t i=0; i+1<n; ++i) { \
+			SLL_SETNEXT(nodes[i], nodes[i+1]); \
+		} \
+		SLL_LNCLEAR(nodes[n-1]); \
+		list->first = nodes[0]; \
+		list->last = nodes[n-1]; \
+		list->n = n; \
+	} /*}}}*/ \
 	void CONCAT(function_prefix, lfree)(list_type *list) { /*{{{*/ \
 		while (CONCAT(function_prefix, lsize)(list) > 0) { \
 			node_type * node = CONCAT(function_prefix, lpopfront)(list); \
 			node_free_func(node); \
 		} \
+	} /*}}}*/ \
+	unsigned CONCAT(function_prefix, ltags)(const node_type *node) { /*{{{*/ \
+		assert(node != NULL); \
+		return (unsigned)((uintptr_t)node->sll_link_next & SLL_TAG_MASK); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, lsettags)(node_type *node, unsigned tags) { /*{{{*/ \
+		assert(node != NULL); \
+		assert(tags <= SLL_TAG_MASK); \
+		node->sll_link_next = (void *)((uintptr_t)SLL_NEXT(node) | tags); \
 	} /*}}}*/
 
 #define SLL_ITER_DEFS(function_prefix, node_type, list_type, iterator_type) \
@@ -169,7 +292,7 @@
 		iter->prev = NULL; \
 		iter->current = list->first; \
 		if (iter->current != NULL) { \
-			iter->next = iter->current->sll_link_next; \
+			iter->next = SLL_NEXT(iter->current); \
 		} \
 	} /*}}}*/ \
 	node_type *CONCAT(function_prefix, iget)(iterator_type *iter) { /*{{{*/ \
@@ -183,7 +306,7 @@
 		} \
 		iter->current = iter->next; \
 		if (iter->current != NULL) { \
-			iter->next = iter->current->sll_link_next; \
+			iter->next = SLL_NEXT(iter->current); \
 		} \
 	} /*}}}*/ \
 	bool CONCAT(function_prefix, iisend)(const iterator_type *iter) { /*{{{*/ \
@@ -205,7 +328,7 @@
 			--iter->list->n; \
 		} \
 		if (iter->prev != NULL) { \
-			iter->prev->sll_link_next = iter->next; \
+			SLL_SETNEXT(iter->prev, iter->next); \
 		} \
 		return node; \
 	} /*}}}*/
@@ -238,6 +361,17 @@
 		assert(node != NULL); \
 		CONCAT(function_prefix, lpushback)((list_type*)pool, node); \
 	} /*}}}*/ \
+	size_t CONCAT(function_prefix, ptrim)(pool_type *pool, size_t keep) { /*{{{*/ \
+		assert(pool != NULL); \
+		list_type excess; \
+		CONCAT(function_prefix, lclear)(&excess); \
+		while (CONCAT(function_prefix, lsize)((list_type*)pool) > keep) { \
+			CONCAT(function_prefix, lpushback)(&excess, CONCAT(function_prefix, lpopfront)((list_type*)pool)); \
+		} \
+		size_t released = CONCAT(function_prefix, lsize)(&excess); \
+		CONCAT(function_prefix, lfree)(&excess); \
+		return released; \
+	} /*}}}*/ \
 	void CONCAT(function_prefix, pfree)(pool_type *pool) { /*{{{*/ \
 		assert(pool != NULL); \
 		CONCAT(function_prefix, lfree)((list_type*)pool); \
@@ -0,0 +1,181 @@
+#pragma once
+
+/*
+ * multi level feedback queue scheduler on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_MLFQ_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_MLFQ_DECLS(mysll, mynode, mylist, mymlfq);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_MLFQ_DEFS(mysll, mynode, mylist, mymlfq);
+ *
+ * where source stuff is appropriate, you get a scheduler type mymlfq with up to SLL_MLFQ_LEVELS
+ * priority levels, each a list, and a bitmap of the non-empty levels so that the highest priority
+ * task is found with a single bit scan. New tasks start at level 0 (the highest). A task that has
+ * used up the quantum of its level, quantum << level, over one or more runs is demoted one level.
+ * A boost moves every task back to level 0 by splicing each level list onto level 0, which is
+ * O(levels) no matter how many tasks are queued; per task accounting is reset lazily through a
+ * boost epoch kept in the task.
+ *
+ * Time is in whatever unit the caller uses consistently for quanta, run times and mqtick.
+ *
+ * void    mysll_mqinit(mymlfq *mlfq, unsigned levels, uint64_t quantum, uint64_t boost)
+ *                                                    // initializes an empty scheduler with levels levels (at most
+ *                                                    // SLL_MLFQ_LEVELS), a level 0 quantum, and a boost period
+ *                                                    // for mqtick (0 for no automatic boost)
+ * size_t  mysll_mqsize(const mymlfq *mlfq)           // returns the number of queued tasks
+ * void    mysll_mqpush(mymlfq *mlfq, mynode *node)   // queues a new task at level 0
+ * mynode *mysll_mqpop(mymlfq *mlfq)                  // removes and returns the highest priority task (or NULL),
+ *                                                    // node->sll_mlfq.level is the level it was taken from
+ * uint64_t mysll_mqquantum(const mymlfq *mlfq, const mynode *node)
+ *                                                    // returns how long the popped task may run before demotion
+ * void    mysll_mqrequeue(mymlfq *mlfq, mynode *node, uint64_t ran)
+ *                                                    // queues a popped task again after it ran for ran, demoting it
+ *                                                    // if it has used up the quantum of its level
+ * void    mysll_mqboost(mymlfq *mlfq)                // moves all queued tasks to level 0
+ * bool    mysll_mqtick(mymlfq *mlfq, uint64_t now)   // boosts if the boost period has passed since the last boost,
+ *                                                    // or since the first tick, returns true if it did
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sll_meta.h"
+
+#ifndef SLL_MLFQ_LEVELS
+#define SLL_MLFQ_LEVELS 8
+#endif
+
+_Static_assert(SLL_MLFQ_LEVELS > 0 && SLL_MLFQ_LEVELS <= 64, "SLL_MLFQ_LEVELS must fit the level bitmap");
+
+// in-type data addition
+#define SLL_MLFQ_LINK \
+	struct { \
+		unsigned level; \
+		uint64_t used; \
+		uint64_t epoch; \
+	} sll_mlfq
+
+// header declarations
+#define SLL_MLFQ_DECLS(function_prefix, node_type, list_type, mlfq_type) \
+	typedef struct { /*{{{*/ \
+		list_type levels[SLL_MLFQ_LEVELS]; \
+		uint64_t nonempty; \
+		unsigned nlevels; \
+		uint64_t quantum; \
+		uint64_t boost; \
+		uint64_t last_boost; \
+		bool ticked; \
+		uint64_t epoch; \
+		size_t n; \
+	} mlfq_type; /*}}}*/ \
+	void       CONCAT(function_prefix, mqinit)   (mlfq_type *mlfq, unsigned levels, uint64_t quantum, uint64_t boost); \
+	size_t     CONCAT(function_prefix, mqsize)   (const mlfq_type *mlfq); \
+	void       CONCAT(function_prefix, mqpush)   (mlfq_type *mlfq, node_type *node); \
+	node_type *CONCAT(function_prefix, mqpop)    (mlfq_type *mlfq); \
+	uint64_t   CONCAT(function_prefix, mqquantum)(const mlfq_type *mlfq, const node_type *node); \
+	void       CONCAT(function_prefix, mqrequeue)(mlfq_type *mlfq, node_type *node, uint64_t ran); \
+	void       CONCAT(function_prefix, mqboost)  (mlfq_type *mlfq); \
+	bool       CONCAT(function_prefix, mqtick)   (mlfq_type *mlfq, uint64_t now)
+
+// definitions
+
+#define SLL_MLFQ_DEFS(function_prefix, node_type, list_type, mlfq_type) \
+	static void CONCAT(function_prefix, mqenqueue)(mlfq_type *mlfq, node_type *node, unsigned level) { /*{{{*/ \
+		node->sll_mlfq.level = level; \
+		CONCAT(function_prefix, lpushback)(&mlfq->levels[level], node); \
+		mlfq->nonempty |= (uint64_t)1 << level; \
+		++mlfq->n; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, mqinit)(mlfq_type *mlfq, unsigned levels, uint64_t quantum, uint64_t boost) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		assert(levels > 0 && levels <= SLL_MLFQ_LEVELS); \
+		for (unsigned i=0; i<SLL_MLFQ_LEVELS; ++i) { \
+			CONCAT(function_prefix, lclear)(&mlfq->levels[i]); \
+		} \
+		mlfq->nonempty = 0; \
+		mlfq->nlevels = levels; \
+		mlfq->quantum = quantum; \
+		mlfq->boost = boost; \
+		mlfq->last_boost = 0; \
+		mlfq->ticked = false; \
+		mlfq->epoch = 0; \
+		mlfq->n = 0; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, mqsize)(const mlfq_type *mlfq) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		return mlfq->n; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, mqpush)(mlfq_type *mlfq, node_type *node) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		assert(node != NULL); \
+		node->sll_mlfq.used = 0; \
+		node->sll_mlfq.epoch = mlfq->epoch; \
+		CONCAT(function_prefix, mqenqueue)(mlfq, node, 0); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, mqpop)(mlfq_type *mlfq) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		if (mlfq->nonempty == 0) { return NULL; } \
+		unsigned level = (unsigned)__builtin_ctzll(mlfq->nonempty); \
+		node_type *node = CONCAT(function_prefix, lpopfront)(&mlfq->levels[level]); \
+		if (mlfq->levels[level].n == 0) { mlfq->nonempty &= ~((uint64_t)1 << level); } \
+		--mlfq->n; \
+		/* the task was queued at a level it may since have been boosted out of */ \
+		node->sll_mlfq.level = level; \
+		if (node->sll_mlfq.epoch != mlfq->epoch) { \
+			node->sll_mlfq.used = 0; \
+			node->sll_mlfq.epoch = mlfq->epoch; \
+		} \
+		return node; \
+	} /*}}}*/ \
+	uint64_t CONCAT(function_prefix, mqquantum)(const mlfq_type *mlfq, const node_type *node) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		assert(node != NULL); \
+		uint64_t quantum = mlfq->quantum << node->sll_mlfq.level; \
+		return node->sll_mlfq.used < quantum ? quantum - node->sll_mlfq.used : 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, mqrequeue)(mlfq_type *mlfq, node_type *node, uint64_t ran) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		assert(node != NULL); \
+		unsigned level = node->sll_mlfq.level; \
+		node->sll_mlfq.used += ran; \
+		if (node->sll_mlfq.used >= mlfq->quantum << level && level + 1 < mlfq->nlevels) { \
+			++level; \
+			node->sll_mlfq.used = 0; \
+		} \
+		CONCAT(function_prefix, mqenqueue)(mlfq, node, level); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, mqboost)(mlfq_type *mlfq) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		for (unsigned i=1; i<mlfq->nlevels; ++i) { \
+			CONCAT(function_prefix, lsplice)(&mlfq->levels[0], &mlfq->levels[i]); \
+		} \
+		mlfq->nonempty = mlfq->levels[0].n > 0 ? 1 : 0; \
+		++mlfq->epoch; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, mqtick)(mlfq_type *mlfq, uint64_t now) { /*{{{*/ \
+		assert(mlfq != NULL); \
+		if (!mlfq->ticked) { \
+			/* the clock may start anywhere, so the first tick only starts the period */ \
+			mlfq->ticked = true; \
+			mlfq->last_boost = now; \
+			return false; \
+		} \
+		if (mlfq->boost == 0 || now - mlfq->last_boost < mlfq->boost) { return false; } \
+		mlfq->last_boost = now; \
+		CONCAT(function_prefix, mqboost)(mlfq); \
+		return true; \
+	} /*}}}*/
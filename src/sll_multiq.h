@@ -0,0 +1,178 @@
+#pragma once
+
+/*
+ * relaxed concurrent priority queue (MultiQueue) over locked sorted lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_MULTIQ_DECLS(mysll, mynode, mylist, mymultiq);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_MULTIQ_DEFS(mysll, mynode, mylist, mymultiq, nodekey);
+ *
+ * where source stuff is appropriate, gives you a thread safe priority queue type mymultiq, ordered by
+ * uint64_t nodekey(const mynode *node) with smaller keys first (UINT64_MAX is reserved), that
+ * spreads its nodes over a number of lists (c times the number of threads using it, c = 2 to 4
+ * works well), each kept sorted and guarded by a lock of its own. A push inserts into a random
+ * list, a pop looks at the smallest keys of two random lists and takes the smaller one, and a list
+ * found locked is simply swapped for another random one, so threads rarely wait on each other. The
+ * price is that a pop returns one of the smallest keys in the queue, usually not the smallest:
+ * ranks are off by about the number of lists on average. Equal keys in the same list come out in
+ * push order.
+ *
+ * Insertion walks the sorted list, so every list should stay short, i.e. use enough lists for the
+ * number of nodes queued at a time.
+ *
+ * bool    mysll_rqinit(mymultiq *queue, size_t lists)   // initializes an empty queue over lists lists, false on failure
+ * void    mysll_rqdestroy(mymultiq *queue)              // releases the lists, nodes still queued are left alone
+ * void    mysll_rqpush(mymultiq *queue, mynode *node)   // inserts node
+ * mynode *mysll_rqpop(mymultiq *queue)                  // removes and returns a node with one of the smallest keys, or NULL
+ *                                                       // if all lists were seen empty
+ * size_t  mysll_rqsize(const mymultiq *queue)           // returns the number of queued nodes
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+#ifndef SLL_CACHELINE
+#define SLL_CACHELINE 64
+#endif
+
+// per thread random state for picking lists, any nonzero seed will do
+static _Thread_local uint64_t sll_multiq_rng = 0;
+
+static inline uint64_t sll_multiq_random(void) {
+	if (sll_multiq_rng == 0) { sll_multiq_rng = (uint64_t)(uintptr_t)&sll_multiq_rng * 0x9e3779b97f4a7c15u | 1; }
+	sll_multiq_rng ^= sll_multiq_rng << 13;
+	sll_multiq_rng ^= sll_multiq_rng >> 7;
+	sll_multiq_rng ^= sll_multiq_rng << 17;
+	return sll_multiq_rng;
+}
+
+// header declarations
+#define SLL_MULTIQ_DECLS(function_prefix, node_type, list_type, multiq_type) \
+	typedef struct { /*{{{*/ \
+		_Alignas(SLL_CACHELINE) pthread_mutex_t lock; \
+		atomic_uint_fast64_t top; \
+		list_type list; \
+	} CONCAT(multiq_type, sub); /*}}}*/ \
+	typedef struct { /*{{{*/ \
+		CONCAT(multiq_type, sub) *subs; \
+		size_t nsubs; \
+		atomic_size_t n; \
+	} multiq_type; /*}}}*/ \
+	bool       CONCAT(function_prefix, rqinit)   (multiq_type *queue, size_t lists); \
+	void       CONCAT(function_prefix, rqdestroy)(multiq_type *queue); \
+	void       CONCAT(function_prefix, rqpush)   (multiq_type *queue, node_type *node); \
+	node_type *CONCAT(function_prefix, rqpop)    (multiq_type *queue); \
+	size_t     CONCAT(function_prefix, rqsize)   (const multiq_type *queue)
+
+// definitions
+
+/*
+ * Every list publishes the key of its first node in top (UINT64_MAX when empty), which pops compare
+ * without taking any lock. A stale top only costs quality, the pop itself happens under the lock.
+ */
+#define SLL_MULTIQ_DEFS(function_prefix, node_type, list_type, multiq_type, node_key_func) \
+	static CONCAT(multiq_type, sub) *CONCAT(function_prefix, rqlockany)(multiq_type *queue) { /*{{{*/ \
+		for (;;) { \
+			CONCAT(multiq_type, sub) *sub = &queue->subs[sll_multiq_random() % queue->nsubs]; \
+			if (pthread_mutex_trylock(&sub->lock) == 0) { return sub; } \
+		} \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, rqsettop)(CONCAT(multiq_type, sub) *sub) { /*{{{*/ \
+		uint64_t top = sub->list.first != NULL ? node_key_func(sub->list.first) : UINT64_MAX; \
+		atomic_store_explicit(&sub->top, top, memory_order_relaxed); \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, rqinit)(multiq_type *queue, size_t lists) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(lists > 0); \
+		queue->subs = aligned_alloc(SLL_CACHELINE, lists * sizeof(CONCAT(multiq_type, sub))); \
+		if (queue->subs == NULL) { return false; } \
+		for (size_t i=0; i<lists; ++i) { \
+			if (pthread_mutex_init(&queue->subs[i].lock, NULL) != 0) { \
+				while (i-- > 0) { pthread_mutex_destroy(&queue->subs[i].lock); } \
+				free(queue->subs); \
+				return false; \
+			} \
+			atomic_init(&queue->subs[i].top, UINT64_MAX); \
+			CONCAT(function_prefix, lclear)(&queue->subs[i].list); \
+		} \
+		queue->nsubs = lists; \
+		atomic_init(&queue->n, 0); \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, rqdestroy)(multiq_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		for (size_t i=0; i<queue->nsubs; ++i) { \
+			pthread_mutex_destroy(&queue->subs[i].lock); \
+		} \
+		free(queue->subs); \
+		queue->subs = NULL; \
+		queue->nsubs = 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, rqpush)(multiq_type *queue, node_type *node) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(node != NULL); \
+		uint64_t prio = node_key_func(node); \
+		CONCAT(multiq_type, sub) *sub = CONCAT(function_prefix, rqlockany)(queue); \
+		list_type *list = &sub->list; \
+		if (list->n == 0 || node_key_func(list->last) <= prio) { \
+			CONCAT(function_prefix, lpushback)(list, node); \
+		} \
+		else if (prio < node_key_func(list->first)) { \
+			SLL_SETNEXT(node, list->first); \
+			list->first = node; \
+			++list->n; \
+		} \
+		else { \
+			/* somewhere in the middle, after the last node with a key not greater than prio */ \
+			node_type *prev = list->first; \
+			while (node_key_func(SLL_NEXT(prev)) <= prio) { prev = SLL_NEXT(prev); } \
+			SLL_SETNEXT(node, SLL_NEXT(prev)); \
+			SLL_SETNEXT(prev, node); \
+			++list->n; \
+		} \
+		CONCAT(function_prefix, rqsettop)(sub); \
+		atomic_fetch_add_explicit(&queue->n, 1, memory_order_relaxed); \
+		pthread_mutex_unlock(&sub->lock); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, rqpop)(multiq_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		for (size_t attempt=0; ; ++attempt) { \
+			CONCAT(multiq_type, sub) *a = &queue->subs[sll_multiq_random() % queue->nsubs]; \
+			CONCAT(multiq_type, sub) *b = &queue->subs[sll_multiq_random() % queue->nsubs]; \
+			uint64_t atop = atomic_load_explicit(&a->top, memory_order_relaxed); \
+			uint64_t btop = atomic_load_explicit(&b->top, memory_order_relaxed); \
+			if (btop < atop) { \
+				a = b; \
+				atop = btop; \
+			} \
+			if (atop == UINT64_MAX) { \
+				/* two empty picks, after a few of those make sure the whole queue is empty */ \
+				if (attempt < queue->nsubs) { continue; } \
+				size_t i = 0; \
+				while (i < queue->nsubs && atomic_load_explicit(&queue->subs[i].top, memory_order_relaxed) == UINT64_MAX) { ++i; } \
+				if (i == queue->nsubs) { return NULL; } \
+				a = &queue->subs[i]; \
+			} \
+			if (pthread_mutex_trylock(&a->lock) != 0) { continue; } \
+			node_type *node = CONCAT(function_prefix, lpopfront)(&a->list); \
+			if (node != NULL) { \
+				CONCAT(function_prefix, rqsettop)(a); \
+				atomic_fetch_sub_explicit(&queue->n, 1, memory_order_relaxed); \
+			} \
+			pthread_mutex_unlock(&a->lock); \
+			if (node != NULL) { return node; } \
+		} \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, rqsize)(const multiq_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return atomic_load_explicit(&queue->n, memory_order_relaxed); \
+	} /*}}}*/
@@ -0,0 +1,184 @@
+#pragma once
+
+/*
+ * order preserving resequencer (reorder buffer) on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_RESEQ_LINK;
+ * 	...
+ * } mynode;
+ *
+ * together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_RESEQ_DECLS(mysll, mynode, mylist, myreseq);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_RESEQ_DEFS(mysll, mynode, mylist, myreseq);
+ *
+ * where source stuff is appropriate, you get a thread safe reorder buffer type myreseq. Workers
+ * finishing sequence numbers out of order put their output into a window of list slots indexed by
+ * sequence number, and the consumer gets the contiguous in-order prefix of finished sequence numbers
+ * spliced onto its list in one go. A sequence number may produce any number of nodes, including
+ * none, by putting a whole list for it. Workers that get ahead of the consumer by a full window
+ * block until the consumer has caught up, which bounds the memory held by the buffer.
+ *
+ * bool    mysll_rinit(myreseq *reseq, size_t window, uint64_t first)
+ *                                                      // initializes a buffer expecting first as the next sequence
+ *                                                      // number, window is rounded up to a power of two, false on failure
+ * void    mysll_rdestroy(myreseq *reseq)               // releases the buffer, nodes still held are left alone
+ * bool    mysll_rput(myreseq *reseq, mynode *node)     // finishes sequence number node->sll_reseq_seq with a single node
+ * bool    mysll_rputlist(myreseq *reseq, uint64_t seq, mylist *nodes)
+ *                                                      // finishes seq with all nodes of the list, leaving it empty
+ *                                                      // both return false, leaving the nodes to the caller, if the buffer
+ *                                                      // was closed while waiting for seq to fit in the window
+ * size_t  mysll_rrelease(myreseq *reseq, mylist *out)  // splices the finished in-order prefix onto out, never blocks,
+ *                                                      // returns the number of sequence numbers released
+ * size_t  mysll_rwait(myreseq *reseq, mylist *out)     // like rrelease, but blocks until something is released or the
+ *                                                      // buffer is closed
+ * void    mysll_rclose(myreseq *reseq)                 // wakes up everybody blocked in rwait, rput or rputlist
+ * uint64_t mysll_rnext(myreseq *reseq)                 // returns the next sequence number to be released
+ *
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "sll_meta.h"
+
+// in-type data addition
+#define SLL_RESEQ_LINK uint64_t sll_reseq_seq
+
+// header declarations
+#define SLL_RESEQ_DECLS(function_prefix, node_type, list_type, reseq_type) \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		bool done; \
+	} CONCAT(reseq_type, slot); /*}}}*/ \
+	typedef struct { /*{{{*/ \
+		CONCAT(reseq_type, slot) *slots; \
+		size_t mask; \
+		uint64_t next; \
+		bool closed; \
+		pthread_mutex_t lock; \
+		pthread_cond_t space; \
+		pthread_cond_t ready; \
+	} reseq_type; /*}}}*/ \
+	bool     CONCAT(function_prefix, rinit)   (reseq_type *reseq, size_t window, uint64_t first); \
+	void     CONCAT(function_prefix, rdestroy)(reseq_type *reseq); \
+	bool     CONCAT(function_prefix, rput)    (reseq_type *reseq, node_type *node); \
+	bool     CONCAT(function_prefix, rputlist)(reseq_type *reseq, uint64_t seq, list_type *nodes); \
+	size_t   CONCAT(function_prefix, rrelease)(reseq_type *reseq, list_type *out); \
+	size_t   CONCAT(function_prefix, rwait)   (reseq_type *reseq, list_type *out); \
+	void     CONCAT(function_prefix, rclose)  (reseq_type *reseq); \
+	uint64_t CONCAT(function_prefix, rnext)   (reseq_type *reseq)
+
+// definitions
+
+#define SLL_RESEQ_DEFS(function_prefix, node_type, list_type, reseq_type) \
+	static size_t CONCAT(function_prefix, rdrain)(reseq_type *reseq, list_type *out) { /*{{{*/ \
+		size_t n = 0; \
+		for (;;) { \
+			CONCAT(reseq_type, slot) *slot = &reseq->slots[reseq->next & reseq->mask]; \
+			if (!slot->done) { break; } \
+			CONCAT(function_prefix, lsplice)(out, &slot->list); \
+			slot->done = false; \
+			++reseq->next; \
+			++n; \
+		} \
+		if (n > 0) { pthread_cond_broadcast(&reseq->space); } \
+		return n; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, rinit)(reseq_type *reseq, size_t window, uint64_t first) { /*{{{*/ \
+		assert(reseq != NULL); \
+		size_t size = 1; \
+		while (size < window) { size <<= 1; } \
+		reseq->slots = malloc(size * sizeof(CONCAT(reseq_type, slot))); \
+		if (reseq->slots == NULL) { return false; } \
+		for (size_t i=0; i<size; ++i) { \
+			CONCAT(function_prefix, lclear)(&reseq->slots[i].list); \
+			reseq->slots[i].done = false; \
+		} \
+		reseq->mask = size - 1; \
+		reseq->next = first; \
+		reseq->closed = false; \
+		pthread_mutex_init(&reseq->lock, NULL); \
+		pthread_cond_init(&reseq->space, NULL); \
+		pthread_cond_init(&reseq->ready, NULL); \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, rdestroy)(reseq_type *reseq) { /*{{{*/ \
+		assert(reseq != NULL); \
+		pthread_cond_destroy(&reseq->ready); \
+		pthread_cond_destroy(&reseq->space); \
+		pthread_mutex_destroy(&reseq->lock); \
+		free(reseq->slots); \
+		reseq->slots = NULL; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, rputlist)(reseq_type *reseq, uint64_t seq, list_type *nodes) { /*{{{*/ \
+		assert(reseq != NULL); \
+		assert(nodes != NULL); \
+		pthread_mutex_lock(&reseq->lock); \
+		assert(seq >= reseq->next); \
+		while (seq - reseq->next > reseq->mask && !reseq->closed) { \
+			pthread_cond_wait(&reseq->space, &reseq->lock); \
+		} \
+		if (seq - reseq->next > reseq->mask) { \
+			pthread_mutex_unlock(&reseq->lock); \
+			return false; \
+		} \
+		CONCAT(reseq_type, slot) *slot = &reseq->slots[seq & reseq->mask]; \
+		assert(!slot->done); \
+		CONCAT(function_prefix, lsplice)(&slot->list, nodes); \
+		slot->done = true; \
+		if (seq == reseq->next) { pthread_cond_signal(&reseq->ready); } \
+		pthread_mutex_unlock(&reseq->lock); \
+		return true; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, rput)(reseq_type *reseq, node_type *node) { /*{{{*/ \
+		assert(node != NULL); \
+		list_type nodes; \
+		CONCAT(function_prefix, lclear)(&nodes); \
+		CONCAT(function_prefix, lpushback)(&nodes, node); \
+		return CONCAT(function_prefix, rputlist)(reseq, node->sll_reseq_seq, &nodes); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, rrelease)(reseq_type *reseq, list_type *out) { /*{{{*/ \
+		assert(reseq != NULL); \
+		assert(out != NULL); \
+		pthread_mutex_lock(&reseq->lock); \
+		size_t n = CONCAT(function_prefix, rdrain)(reseq, out); \
+		pthread_mutex_unlock(&reseq->lock); \
+		return n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, rwait)(reseq_type *reseq, list_type *out) { /*{{{*/ \
+		assert(reseq != NULL); \
+		assert(out != NULL); \
+		pthread_mutex_lock(&reseq->lock); \
+		size_t n; \
+		while ((n = CONCAT(function_prefix, rdrain)(reseq, out)) == 0 && !reseq->closed) { \
+			pthread_cond_wait(&reseq->ready, &reseq->lock); \
+		} \
+		pthread_mutex_unlock(&reseq->lock); \
+		return n; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, rclose)(reseq_type *reseq) { /*{{{*/ \
+		assert(reseq != NULL); \
+		pthread_mutex_lock(&reseq->lock); \
+		reseq->closed = true; \
+		pthread_cond_broadcast(&reseq->ready); \
+		pthread_cond_broadcast(&reseq->space); \
+		pthread_mutex_unlock(&reseq->lock); \
+	} /*}}}*/ \
+	uint64_t CONCAT(function_prefix, rnext)(reseq_type *reseq) { /*{{{*/ \
+		assert(reseq != NULL); \
+		pthread_mutex_lock(&reseq->lock); \
+		uint64_t next = reseq->next; \
+		pthread_mutex_unlock(&reseq->lock); \
+		return next; \
+	} /*}}}*/
@@ -0,0 +1,137 @@
+#pragma once
+
+/*
+ * bounded lock free MPMC ring of node pointers, to go with the lists and pools from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS (and usually SLL_POOL_DECLS and
+ * SLL_POOL_DEFS) as described in sll_meta.h, the following
+ *
+ * SLL_RING_DECLS(mysll, mynode, myring);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_RING_DEFS(mysll, mynode, myring);
+ *
+ * where source stuff is appropriate, gives you a bounded multi producer multi consumer queue type
+ * myring of mynode pointers, using per slot sequence numbers (Vyukov). Unlike the intrusive lists it
+ * never writes to sll_link_next or anything else in the node, so passing a node through the ring
+ * does not move the node's cache line between producer and consumer; only the slot does. Nodes can
+ * come from, and go back to, a pool as usual.
+ *
+ * bool    mysll_minit(myring *ring, size_t capacity)   // initializes an empty ring, capacity is rounded up to a power of
+ *                                                      // two, returns false on failure
+ * void    mysll_mdestroy(myring *ring)                 // releases the ring, nodes still queued are left alone
+ * size_t  mysll_mcapacity(const myring *ring)          // returns the number of slots in the ring
+ * size_t  mysll_msize(myring *ring)                    // returns the number of queued nodes (a snapshot when shared)
+ * bool    mysll_mpushback(myring *ring, mynode *node)  // appends a node, returns false if the ring is full
+ * mynode *mysll_mpopfront(myring *ring)                // removes and returns the first node (or NULL if empty)
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sll_meta.h"
+
+#ifndef SLL_CACHELINE
+#define SLL_CACHELINE 64
+#endif
+
+// header declarations
+#define SLL_RING_DECLS(function_prefix, node_type, ring_type) \
+	typedef struct { /*{{{*/ \
+		atomic_size_t seq; \
+		node_type *node; \
+	} CONCAT(ring_type, slot); /*}}}*/ \
+	typedef struct { /*{{{*/ \
+		_Alignas(SLL_CACHELINE) atomic_size_t head; \
+		_Alignas(SLL_CACHELINE) atomic_size_t tail; \
+		_Alignas(SLL_CACHELINE) CONCAT(ring_type, slot) *slots; \
+		size_t mask; \
+	} ring_type; /*}}}*/ \
+	bool       CONCAT(function_prefix, minit)    (ring_type *ring, size_t capacity); \
+	void       CONCAT(function_prefix, mdestroy) (ring_type *ring); \
+	size_t     CONCAT(function_prefix, mcapacity)(const ring_type *ring); \
+	size_t     CONCAT(function_prefix, msize)    (ring_type *ring); \
+	bool       CONCAT(function_prefix, mpushback)(ring_type *ring, node_type *node); \
+	node_type *CONCAT(function_prefix, mpopfront)(ring_type *ring)
+
+// definitions
+
+#define SLL_RING_DEFS(function_prefix, node_type, ring_type) \
+	bool CONCAT(function_prefix, minit)(ring_type *ring, size_t capacity) { /*{{{*/ \
+		assert(ring != NULL); \
+		size_t size = 2; \
+		while (size < capacity) { size <<= 1; } \
+		ring->slots = malloc(size * sizeof(CONCAT(ring_type, slot))); \
+		if (ring->slots == NULL) { return false; } \
+		for (size_t i=0; i<size; ++i) { \
+			atomic_init(&ring->slots[i].seq, i); \
+			ring->slots[i].node = NULL; \
+		} \
+		ring->mask = size - 1; \
+		atomic_init(&ring->head, 0); \
+		atomic_init(&ring->tail, 0); \
+		return true; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, mdestroy)(ring_type *ring) { /*{{{*/ \
+		assert(ring != NULL); \
+		free(ring->slots); \
+		ring->slots = NULL; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, mcapacity)(const ring_type *ring) { /*{{{*/ \
+		assert(ring != NULL); \
+		return ring->mask + 1; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, msize)(ring_type *ring) { /*{{{*/ \
+		assert(ring != NULL); \
+		size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed); \
+		size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed); \
+		return tail - head <= ring->mask + 1 ? tail - head : 0; \
+	} /*}}}*/ \
+	bool CONCAT(function_prefix, mpushback)(ring_type *ring, node_type *node) { /*{{{*/ \
+		assert(ring != NULL); \
+		assert(node != NULL); \
+		CONCAT(ring_type, slot) *slot; \
+		size_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed); \
+		for (;;) { \
+			slot = &ring->slots[pos & ring->mask]; \
+			size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire); \
+			intptr_t dif = (intptr_t)seq - (intptr_t)pos; \
+			if (dif == 0) { \
+				if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) { break; } \
+			} \
+			else if (dif < 0) { \
+				return false; \
+			} \
+			else { \
+				pos = atomic_load_explicit(&ring->tail, memory_order_relaxed); \
+			} \
+		} \
+		slot->node = node; \
+		atomic_store_explicit(&slot->seq, pos + 1, memory_order_release); \
+		return true; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, mpopfront)(ring_type *ring) { /*{{{*/ \
+		assert(ring != NULL); \
+		CONCAT(ring_type, slot) *slot; \
+		size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed); \
+		for (;;) { \
+			slot = &ring->slots[pos & ring->mask]; \
+			size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire); \
+			intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1); \
+			if (dif == 0) { \
+				if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) { break; } \
+			} \
+			else if (dif < 0) { \
+				return NULL; \
+			} \
+			else { \
+				pos = atomic_load_explicit(&ring->head, memory_order_relaxed); \
+			} \
+		} \
+		node_type *node = slot->node; \
+		atomic_store_explicit(&slot->seq, pos + ring->mask + 1, memory_order_release); \
+		return node; \
+	} /*}}}*/
@@ -0,0 +1,195 @@
+#pragma once
+
+/*
+ * slab backed node pool with locality aware reuse, as an alternative to the pool in sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS and SLL_DEFS as described in sll_meta.h,
+ * the following
+ *
+ * SLL_SLAB_DECLS(mysll, mynode, mylist, myslabpool);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_SLAB_DEFS(mysll, mynode, mylist, myslabpool);
+ *
+ * where source stuff is appropriate, gives you a pool type myslabpool that carves nodes out of
+ * SLL_SLAB_SIZE aligned slabs. Every slab keeps track of its free nodes with a bitmap and hands
+ * out the free node with the lowest address, and nodes are taken from one slab until it runs dry,
+ * after which one of the fullest slabs that still have free nodes is picked. Slabs with free nodes
+ * are kept in SLL_SLAB_BUCKETS buckets by how full they are, so picking does not walk the pool, and
+ * a slab is only moved down to the bucket it belongs in when a pick comes across it. Consecutive gets therefore
+ * return nodes in ascending address order within the same slab even after heavy churn, and lists
+ * built from them traverse well, while mostly empty slabs are left to drain so that they can be
+ * trimmed. The plain pool in sll_meta.h recycles nodes in return order, which after churn
+ * scatters consecutive gets over the whole heap.
+ *
+ * Nodes from a slab pool must only be returned to the pool they came from and never free'd
+ * directly, so lists of them must not be released with lfree unless node_free_func is a no-op.
+ * Nodes from a fresh slab are zeroed, recycled nodes are handed out as they were returned.
+ *
+ * void    mysll_spinit(myslabpool *pool)                  // initializes an empty pool
+ * mynode *mysll_spget(myslabpool *pool)                   // returns a node from the pool (or NULL if out of memory)
+ * void    mysll_spreturn(myslabpool *pool, mynode *node)  // puts the node back in the pool
+ * size_t  mysll_spinuse(const myslabpool *pool)           // returns the number of nodes currently handed out
+ * size_t  mysll_spslabs(const myslabpool *pool)           // returns the number of slabs held by the pool
+ * size_t  mysll_sptrim(myslabpool *pool)                  // releases slabs with no nodes handed out, returns how many
+ * void    mysll_spfree(myslabpool *pool)                  // releases all slabs, also those with nodes handed out
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "sll_meta.h"
+
+#ifndef SLL_SLAB_SIZE
+#define SLL_SLAB_SIZE (64*1024)
+#endif
+
+#ifndef SLL_SLAB_BUCKETS
+#define SLL_SLAB_BUCKETS 16
+#endif
+
+#define SLL_SLAB_OF(slab_type, node) ((slab_type *)((uintptr_t)(node) & ~(uintptr_t)(SLL_SLAB_SIZE - 1)))
+#define SLL_SLAB_WORDS(node_type) ((SLL_SLAB_SIZE / sizeof(node_type) + 63) / 64)
+
+// header declarations
+#define SLL_SLAB_DECLS(function_prefix, node_type, list_type, pool_type) \
+	typedef struct CONCAT(pool_type, slab) { /*{{{*/ \
+		SLL_LINK(CONCAT(pool_type, slab)); \
+		size_t used; \
+		size_t hint; \
+		size_t bucket; \
+		struct CONCAT(pool_type, slab) *partial; \
+		uint64_t free[SLL_SLAB_WORDS(node_type)]; \
+		node_type nodes[]; \
+	} CONCAT(pool_type, slab); /*}}}*/ \
+	SLL_DECLS(CONCAT(function_prefix, sp), CONCAT(pool_type, slab), CONCAT(pool_type, slablist)); \
+	typedef struct { /*{{{*/ \
+		CONCAT(pool_type, slablist) slabs; \
+		CONCAT(pool_type, slab) *current; \
+		CONCAT(pool_type, slab) *partial[SLL_SLAB_BUCKETS]; \
+		size_t inuse; \
+	} pool_type; /*}}}*/ \
+	void       CONCAT(function_prefix, spinit)  (pool_type *pool); \
+	node_type *CONCAT(function_prefix, spget)   (pool_type *pool); \
+	void       CONCAT(function_prefix, spreturn)(pool_type *pool, node_type *node); \
+	size_t     CONCAT(function_prefix, spinuse) (const pool_type *pool); \
+	size_t     CONCAT(function_prefix, spslabs) (const pool_type *pool); \
+	size_t     CONCAT(function_prefix, sptrim)  (pool_type *pool); \
+	void       CONCAT(function_prefix, spfree)  (pool_type *pool)
+
+// definitions
+
+#define SLL_SLAB_DEFS(function_prefix, node_type, list_type, pool_type) \
+	SLL_DEFS(CONCAT(function_prefix, sp), CONCAT(pool_type, slab), CONCAT(pool_type, slablist), free) \
+	enum { CONCAT(pool_type, slabcap) = (SLL_SLAB_SIZE - sizeof(CONCAT(pool_type, slab))) / sizeof(node_type) }; \
+	_Static_assert(CONCAT(pool_type, slabcap) > 0, "SLL_SLAB_SIZE too small for node type"); \
+	static CONCAT(pool_type, slab) *CONCAT(function_prefix, spnew)(pool_type *pool) { /*{{{*/ \
+		CONCAT(pool_type, slab) *slab = aligned_alloc(SLL_SLAB_SIZE, SLL_SLAB_SIZE); \
+		if (slab == NULL) { return NULL; } \
+		memset(slab, 0, SLL_SLAB_SIZE); \
+		for (size_t i=0; i<CONCAT(pool_type, slabcap); ++i) { \
+			slab->free[i / 64] |= (uint64_t)1 << (i % 64); \
+		} \
+		slab->used = 0; \
+		slab->hint = 0; \
+		slab->bucket = SLL_SLAB_BUCKETS; \
+		CONCAT(CONCAT(function_prefix, sp), lpushback)(&pool->slabs, slab); \
+		return slab; \
+	} /*}}}*/ \
+	static size_t CONCAT(function_prefix, spbucket)(const CONCAT(pool_type, slab) *slab) { /*{{{*/ \
+		return slab->used * SLL_SLAB_BUCKETS / CONCAT(pool_type, slabcap); \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, spfile)(pool_type *pool, CONCAT(pool_type, slab) *slab) { /*{{{*/ \
+		slab->bucket = CONCAT(function_prefix, spbucket)(slab); \
+		slab->partial = pool->partial[slab->bucket]; \
+		pool->partial[slab->bucket] = slab; \
+	} /*}}}*/ \
+	static CONCAT(pool_type, slab) *CONCAT(function_prefix, sppick)(pool_type *pool) { /*{{{*/ \
+		/* returns only ever lower the fill of a filed slab, so a slab found above its bucket */ \
+		/* is refiled further down and met again later in the scan */ \
+		for (size_t b=SLL_SLAB_BUCKETS; b-- > 0; ) { \
+			CONCAT(pool_type, slab) *slab; \
+			while ((slab = pool->partial[b]) != NULL) { \
+				pool->partial[b] = slab->partial; \
+				if (CONCAT(function_prefix, spbucket)(slab) == b) { \
+					slab->bucket = SLL_SLAB_BUCKETS; \
+					return slab; \
+				} \
+				CONCAT(function_prefix, spfile)(pool, slab); \
+			} \
+		} \
+		return NULL; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, spinit)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		CONCAT(CONCAT(function_prefix, sp), lclear)(&pool->slabs); \
+		pool->current = NULL; \
+		memset(pool->partial, 0, sizeof(pool->partial)); \
+		pool->inuse = 0; \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, spget)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		CONCAT(pool_type, slab) *slab = pool->current; \
+		if (slab == NULL || slab->used == CONCAT(pool_type, slabcap)) { \
+			slab = CONCAT(function_prefix, sppick)(pool); \
+			if (slab == NULL) { slab = CONCAT(function_prefix, spnew)(pool); } \
+			if (slab == NULL) { return NULL; } \
+			pool->current = slab; \
+		} \
+		while (slab->free[slab->hint] == 0) { ++slab->hint; } \
+		size_t i = slab->hint * 64 + (size_t)__builtin_ctzll(slab->free[slab->hint]); \
+		slab->free[slab->hint] &= slab->free[slab->hint] - 1; \
+		++slab->used; \
+		++pool->inuse; \
+		return &slab->nodes[i]; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, spreturn)(pool_type *pool, node_type *node) { /*{{{*/ \
+		assert(pool != NULL); \
+		assert(node != NULL); \
+		CONCAT(pool_type, slab) *slab = SLL_SLAB_OF(CONCAT(pool_type, slab), node); \
+		assert(slab->used > 0); \
+		size_t i = (size_t)(node - slab->nodes); \
+		slab->free[i / 64] |= (uint64_t)1 << (i % 64); \
+		if (i / 64 < slab->hint) { slab->hint = i / 64; } \
+		/* a full slab other than the current one is on no bucket yet */ \
+		if (slab->used-- == CONCAT(pool_type, slabcap) && slab != pool->current) { CONCAT(function_prefix, spfile)(pool, slab); } \
+		--pool->inuse; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, spinuse)(const pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		return pool->inuse; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, spslabs)(const pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		return pool->slabs.n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, sptrim)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		CONCAT(pool_type, slablist) kept; \
+		CONCAT(pool_type, slab) *slab; \
+		size_t released = 0; \
+		CONCAT(CONCAT(function_prefix, sp), lclear)(&kept); \
+		memset(pool->partial, 0, sizeof(pool->partial)); \
+		while ((slab = CONCAT(CONCAT(function_prefix, sp), lpopfront)(&pool->slabs)) != NULL) { \
+			if (slab->used == 0) { \
+				if (slab == pool->current) { pool->current = NULL; } \
+				free(slab); \
+				++released; \
+			} \
+			else { \
+				CONCAT(CONCAT(function_prefix, sp), lpushback)(&kept, slab); \
+				if (slab->bucket < SLL_SLAB_BUCKETS) { CONCAT(function_prefix, spfile)(pool, slab); } \
+			} \
+		} \
+		pool->slabs = kept; \
+		return released; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, spfree)(pool_type *pool) { /*{{{*/ \
+		assert(pool != NULL); \
+		CONCAT(CONCAT(function_prefix, sp), lfree)(&pool->slabs); \
+		pool->current = NULL; \
+		memset(pool->partial, 0, sizeof(pool->partial)); \
+		pool->inuse = 0; \
+	} /*}}}*/
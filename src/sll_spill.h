@@ -0,0 +1,256 @@
+#pragma once
+
+/*
+ * memory capped queue that spills its middle to disk, on top of the singly linked lists from sll_meta.h
+ *
+ * given a node type set up with SLL_LINK, SLL_DECLS, SLL_DEFS, SLL_POOL_DECLS and SLL_POOL_DEFS as
+ * described in sll_meta.h, the following
+ *
+ * SLL_SPILL_DECLS(mysll, mynode, mylist, mypool, myspill);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_SPILL_DEFS(mysll, mynode, mylist, mypool, myspill, nodeencode, nodedecode);
+ *
+ * where source stuff is appropriate, gives you a FIFO queue type myspill that keeps at most cap nodes,
+ * plus one batch read back from disk, in memory. The queue is a head list the consumer pops from, a
+ * segment on disk, and a tail list the producer pushes to. When the nodes in memory exceed the cap,
+ * the oldest nodes of the tail are serialized in batches of up to batch nodes with
+ *
+ * size_t nodeencode(const mynode *node, void *buf)        // writes at most SLL_SPILL_RECORD bytes, returns how many
+ *
+ * appended to the spill file with a single write, and returned to the pool. When the head runs empty,
+ * the next batch of records is read back into nodes from the pool, a buffer full per read, with
+ *
+ * bool   nodedecode(mynode *node, const void *buf, size_t len)
+ *                                                         // restores a node, false if the record is corrupt
+ *
+ * and the kernel is asked to read ahead the buffer after it, so the consumer catching up is fed by
+ * sequential I/O. Once the disk segment is drained the file is truncated again. The spill file is
+ * an anonymous file in the given directory, it disappears when the queue is closed or the process dies.
+ *
+ * int     mysll_dqopen(myspill *queue, const char *dir, size_t cap, size_t batch)
+ *                                                          // initializes an empty queue spilling into dir, returns 0 or an
+ *                                                          // error number
+ * void    mysll_dqclose(myspill *queue, mypool *pool)      // returns the nodes in memory to pool, discards the spilled ones
+ * int     mysll_dqpush(myspill *queue, mypool *pool, mynode *node)
+ *                                                          // appends node, spilling if needed, returns 0 or the error number
+ *                                                          // of a failed spill, in which case the node is queued anyway and
+ *                                                          // the queue stays above its cap until a later spill succeeds
+ * mynode *mysll_dqpop(myspill *queue, mypool *pool)        // removes and returns the first node, or NULL if the queue is
+ *                                                          // empty or reading back failed, with errno set in the latter case
+ * size_t  mysll_dqsize(const myspill *queue)               // returns the number of queued nodes
+ * size_t  mysll_dqspilled(const myspill *queue)            // returns the number of queued nodes that are on disk
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "sll_meta.h"
+
+#ifndef SLL_SPILL_RECORD
+#define SLL_SPILL_RECORD 4096
+#endif
+
+#ifndef SLL_SPILL_BUFFER
+#define SLL_SPILL_BUFFER (1024*1024)
+#endif
+
+_Static_assert(SLL_SPILL_BUFFER >= SLL_SPILL_RECORD + sizeof(uint32_t), "SLL_SPILL_BUFFER must hold a record");
+
+// header declarations
+#define SLL_SPILL_DECLS(function_prefix, node_type, list_type, pool_type, spill_type) \
+	typedef struct { /*{{{*/ \
+		list_type head; \
+		list_type tail; \
+		size_t spilled; \
+		off_t rpos; \
+		off_t wpos; \
+		int fd; \
+		char *wbuf; \
+		char *rbuf; \
+		size_t rhead; \
+		size_t rtail; \
+		size_t cap; \
+		size_t batch; \
+	} spill_type; /*}}}*/ \
+	int        CONCAT(function_prefix, dqopen)   (spill_type *queue, const char *dir, size_t cap, size_t batch); \
+	void       CONCAT(function_prefix, dqclose)  (spill_type *queue, pool_type *pool); \
+	int        CONCAT(function_prefix, dqpush)   (spill_type *queue, pool_type *pool, node_type *node); \
+	node_type *CONCAT(function_prefix, dqpop)    (spill_type *queue, pool_type *pool); \
+	size_t     CONCAT(function_prefix, dqsize)   (const spill_type *queue); \
+	size_t     CONCAT(function_prefix, dqspilled)(const spill_type *queue)
+
+// definitions
+
+/*
+ * Records on disk are a native endian uint32_t length followed by that many bytes, the file never
+ * leaves the process that wrote it.
+ */
+#define SLL_SPILL_DEFS(function_prefix, node_type, list_type, pool_type, spill_type, node_encode_func, node_decode_func) \
+	static int CONCAT(function_prefix, dqspill)(spill_type *queue, pool_type *pool) { /*{{{*/ \
+		list_type batch; \
+		size_t len = 0; \
+		CONCAT(function_prefix, lclear)(&batch); \
+		while (batch.n < queue->batch && queue->tail.n > 0 && SLL_SPILL_BUFFER - len >= SLL_SPILL_RECORD + sizeof(uint32_t)) { \
+			node_type *node = CONCAT(function_prefix, lpopfront)(&queue->tail); \
+			size_t size = node_encode_func(node, queue->wbuf + len + sizeof(uint32_t)); \
+			assert(size <= SLL_SPILL_RECORD); \
+			uint32_t size32 = (uint32_t)size; \
+			memcpy(queue->wbuf + len, &size32, sizeof(size32)); \
+			len += sizeof(uint32_t) + size; \
+			CONCAT(function_prefix, lpushback)(&batch, node); \
+		} \
+		size_t done = 0; \
+		while (done < len) { \
+			ssize_t n = pwrite(queue->fd, queue->wbuf + done, len - done, queue->wpos + (off_t)done); \
+			if (n < 0 && errno == EINTR) { continue; } \
+			if (n <= 0) { \
+				/* the records past wpos are garbage the next spill overwrites, the nodes go back in front */ \
+				int err = n < 0 ? errno : ENOSPC; \
+				CONCAT(function_prefix, lsplice)(&batch, &queue->tail); \
+				queue->tail = batch; \
+				return err; \
+			} \
+			done += (size_t)n; \
+		} \
+		queue->wpos += (off_t)len; \
+		queue->spilled += batch.n; \
+		CONCAT(function_prefix, lsplice)(pool, &batch); \
+		return 0; \
+	} /*}}}*/ \
+	static int CONCAT(function_prefix, dqfill)(spill_type *queue, pool_type *pool) { /*{{{*/ \
+		size_t filled = 0; \
+		while (filled < queue->batch && queue->spilled > 0) { \
+			size_t have = queue->rtail - queue->rhead; \
+			uint32_t size = 0; \
+			if (have >= sizeof(uint32_t)) { \
+				memcpy(&size, queue->rbuf + queue->rhead, sizeof(size)); \
+				if (size > SLL_SPILL_RECORD) { return EIO; } \
+			} \
+			if (have < sizeof(uint32_t) || have - sizeof(uint32_t) < size) { \
+				/* out of buffered records, read the next buffer full and ask for the one after it */ \
+				memmove(queue->rbuf, queue->rbuf + queue->rhead, have); \
+				queue->rhead = 0; \
+				queue->rtail = have; \
+				size_t want = SLL_SPILL_BUFFER - have; \
+				if ((off_t)want > queue->wpos - queue->rpos) { want = (size_t)(queue->wpos - queue->rpos); } \
+				if (want == 0) { return EIO; } \
+				ssize_t got = pread(queue->fd, queue->rbuf + have, want, queue->rpos); \
+				if (got < 0 && errno == EINTR) { continue; } \
+				if (got <= 0) { return got < 0 ? errno : EIO; } \
+				queue->rtail += (size_t)got; \
+				queue->rpos += (off_t)got; \
+				if (queue->rpos < queue->wpos) { \
+					posix_fadvise(queue->fd, queue->rpos, SLL_SPILL_BUFFER, POSIX_FADV_WILLNEED); \
+				} \
+				continue; \
+			} \
+			node_type *node = CONCAT(function_prefix, pget)(pool); \
+			if (node == NULL) { return ENOMEM; } \
+			if (!node_decode_func(node, queue->rbuf + queue->rhead + sizeof(uint32_t), size)) { \
+				CONCAT(function_prefix, preturn)(pool, node); \
+				return EIO; \
+			} \
+			CONCAT(function_prefix, lpushback)(&queue->head, node); \
+			queue->rhead += sizeof(uint32_t) + size; \
+			--queue->spilled; \
+			++filled; \
+		} \
+		if (queue->spilled == 0) { \
+			/* drained, start the file over instead of letting it grow forever */ \
+			queue->rhead = 0; \
+			queue->rtail = 0; \
+			queue->rpos = 0; \
+			queue->wpos = 0; \
+			if (ftruncate(queue->fd, 0) < 0) { return errno; } \
+		} \
+		return 0; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, dqopen)(spill_type *queue, const char *dir, size_t cap, size_t batch) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(dir != NULL); \
+		assert(batch > 0); \
+		queue->wbuf = malloc(SLL_SPILL_BUFFER); \
+		queue->rbuf = malloc(SLL_SPILL_BUFFER); \
+		if (queue->wbuf == NULL || queue->rbuf == NULL) { \
+			free(queue->wbuf); \
+			free(queue->rbuf); \
+			return ENOMEM; \
+		} \
+		/* unlinked right away, the file only lives as long as the descriptor */ \
+		char path[PATH_MAX]; \
+		int len = snprintf(path, sizeof(path), "%s/sll_spill.XXXXXX", dir); \
+		queue->fd = len > 0 && (size_t)len < sizeof(path) ? mkstemp(path) : (errno = ENAMETOOLONG, -1); \
+		if (queue->fd < 0) { \
+			int err = errno; \
+			free(queue->wbuf); \
+			free(queue->rbuf); \
+			return err; \
+		} \
+		unlink(path); \
+		fcntl(queue->fd, F_SETFD, FD_CLOEXEC); \
+		posix_fadvise(queue->fd, 0, 0, POSIX_FADV_SEQUENTIAL); \
+		CONCAT(function_prefix, lclear)(&queue->head); \
+		CONCAT(function_prefix, lclear)(&queue->tail); \
+		queue->spilled = 0; \
+		queue->rhead = 0; \
+		queue->rtail = 0; \
+		queue->rpos = 0; \
+		queue->wpos = 0; \
+		queue->cap = cap; \
+		queue->batch = batch; \
+		return 0; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, dqclose)(spill_type *queue, pool_type *pool) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(pool != NULL); \
+		CONCAT(function_prefix, lsplice)(pool, &queue->head); \
+		CONCAT(function_prefix, lsplice)(pool, &queue->tail); \
+		close(queue->fd); \
+		free(queue->wbuf); \
+		free(queue->rbuf); \
+		queue->fd = -1; \
+		queue->wbuf = NULL; \
+		queue->rbuf = NULL; \
+		queue->spilled = 0; \
+	} /*}}}*/ \
+	int CONCAT(function_prefix, dqpush)(spill_type *queue, pool_type *pool, node_type *node) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(pool != NULL); \
+		assert(node != NULL); \
+		CONCAT(function_prefix, lpushback)(&queue->tail, node); \
+		if (queue->head.n + queue->tail.n <= queue->cap) { return 0; } \
+		/* the head is what the consumer gets next, so the oldest of the tail goes */ \
+		return CONCAT(function_prefix, dqspill)(queue, pool); \
+	} /*}}}*/ \
+	node_type *CONCAT(function_prefix, dqpop)(spill_type *queue, pool_type *pool) { /*{{{*/ \
+		assert(queue != NULL); \
+		assert(pool != NULL); \
+		if (queue->head.n == 0) { \
+			if (queue->spilled > 0) { \
+				int err = CONCAT(function_prefix, dqfill)(queue, pool); \
+				if (err != 0 && queue->head.n == 0) { \
+					errno = err; \
+					return NULL; \
+				} \
+			} \
+			else { \
+				CONCAT(function_prefix, lsplice)(&queue->head, &queue->tail); \
+			} \
+		} \
+		return CONCAT(function_prefix, lpopfront)(&queue->head); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, dqsize)(const spill_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return queue->head.n + queue->spilled + queue->tail.n; \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, dqspilled)(const spill_type *queue) { /*{{{*/ \
+		assert(queue != NULL); \
+		return queue->spilled; \
+	} /*}}}*/
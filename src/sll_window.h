@@ -0,0 +1,178 @@
+#pragma once
+
+/*
+ * sliding window list with incrementally maintained aggregates, on top of sll_meta.h
+ *
+ * given a node type on the form
+ *
+ * struct mynode {
+ * 	...
+ * 	SLL_LINK(mynode);
+ * 	SLL_WINDOW_LINK(myagg);
+ * 	...
+ * } mynode;
+ *
+ * where myagg is the aggregate type, together with the following
+ *
+ * SLL_DECLS(mysll, mynode, mylist);
+ * SLL_WINDOW_DECLS(mysll, mynode, mylist, mywindow, myagg);
+ *
+ * where header stuff is appropriate, and
+ *
+ * SLL_DEFS(mysll, mynode, mylist, nodefree);
+ * SLL_WINDOW_DEFS(mysll, mynode, mylist, mywindow, myagg, identity, aggcombine, nodeagg);
+ *
+ * where source stuff is appropriate, you get a window type mywindow holding the nodes pushed during
+ * the last max_age time units and/or the last max_count nodes, expiring nodes from the head as the
+ * window advances. The aggregate over the window is a monoid given by the expression identity and
+ * myagg aggcombine(myagg a, myagg b), which must be associative but need not be commutative, over
+ * the values myagg nodeagg(const mynode *node). It is kept up to date with the two stacks technique:
+ * the list is split in a front part, where every node holds the aggregate from itself to the end
+ * of the front part, and a back part of which only the total is kept. Pushing combines into the
+ * back total, expiring pops the front, and when the front runs empty the back part becomes the
+ * front by a pass that computes its suffix aggregates. Every node takes part in one such pass, so
+ * push and expiry are amortized O(1) combines, and a query is a single combine.
+ *
+ * For the common case of sum, count, min and max over integer samples, use sll_window_stats as
+ * myagg, SLL_WINDOW_STATS_IDENTITY as identity, sll_window_stats_combine as aggcombine and have
+ * nodeagg return sll_window_stats_of(sample).
+ *
+ * Expired nodes are appended to the list passed as expired, which can simply be spliced into a pool.
+ *
+ * void   mysll_swinit(mywindow *win, size_t max_count, uint64_t max_age)
+ *                                                  // initializes an empty window, a limit of 0 means no limit
+ * void   mysll_swpush(mywindow *win, mynode *node, uint64_t now, mylist *expired)
+ *                                                  // appends node, stamped with now, and expires what falls out
+ * void   mysll_swadvance(mywindow *win, uint64_t now, mylist *expired)
+ *                                                  // expires the nodes pushed max_age or longer before now
+ * myagg  mysll_swquery(const mywindow *win)        // returns the aggregate over the nodes in the window
+ * size_t mysll_swsize(const mywindow *win)         // returns the number of nodes in the window
+ * void   mysll_swclear(mywindow *win, mylist *expired)
+ *                                                  // expires all nodes
+ *
+ */
+
+#include <stdint.h>
+#include "sll_meta.h"
+
+typedef struct {
+	uint64_t count;
+	int64_t sum;
+	int64_t min;
+	int64_t max;
+} sll_window_stats;
+
+#define SLL_WINDOW_STATS_IDENTITY ((sll_window_stats){ .count=0, .sum=0, .min=INT64_MAX, .max=INT64_MIN })
+
+static inline sll_window_stats sll_window_stats_of(int64_t sample) {
+	return (sll_window_stats){ .count=1, .sum=sample, .min=sample, .max=sample };
+}
+
+static inline sll_window_stats sll_window_stats_combine(sll_window_stats a, sll_window_stats b) {
+	return (sll_window_stats){
+		.count=a.count + b.count,
+		.sum=a.sum + b.sum,
+		.min=a.min < b.min ? a.min : b.min,
+		.max=a.max > b.max ? a.max : b.max,
+	};
+}
+
+// in-type data addition
+#define SLL_WINDOW_LINK(agg_type) \
+	struct { \
+		uint64_t time; \
+		agg_type agg; \
+	} sll_window
+
+// header declarations
+#define SLL_WINDOW_DECLS(function_prefix, node_type, list_type, window_type, agg_type) \
+	typedef struct { /*{{{*/ \
+		list_type list; \
+		node_type *back; \
+		agg_type back_agg; \
+		size_t max_count; \
+		uint64_t max_age; \
+	} window_type; /*}}}*/ \
+	void     CONCAT(function_prefix, swinit)   (window_type *win, size_t max_count, uint64_t max_age); \
+	void     CONCAT(function_prefix, swpush)   (window_type *win, node_type *node, uint64_t now, list_type *expired); \
+	void     CONCAT(function_prefix, swadvance)(window_type *win, uint64_t now, list_type *expired); \
+	agg_type CONCAT(function_prefix, swquery)  (const window_type *win); \
+	size_t   CONCAT(function_prefix, swsize)   (const window_type *win); \
+	void     CONCAT(function_prefix, swclear)  (window_type *win, list_type *expired)
+
+// definitions
+
+#define SLL_WINDOW_DEFS(function_prefix, node_type, list_type, window_type, agg_type, agg_identity, agg_combine_func, node_agg_func) \
+	static void CONCAT(function_prefix, swflip)(window_type *win) { /*{{{*/ \
+		/* the front is empty, so the whole list is the back part: reverse it to walk it from the end, \
+		 * then reverse it again while storing the suffix aggregates */ \
+		node_type *prev = NULL, *node = win->list.first; \
+		while (node != NULL) { \
+			node_type *next = SLL_NEXT(node); \
+			SLL_SETNEXT(node, prev); \
+			prev = node; \
+			node = next; \
+		} \
+		agg_type agg = (agg_identity); \
+		node = prev; \
+		prev = NULL; \
+		while (node != NULL) { \
+			node_type *next = SLL_NEXT(node); \
+			agg = agg_combine_func(node_agg_func(node), agg); \
+			node->sll_window.agg = agg; \
+			SLL_SETNEXT(node, prev); \
+			prev = node; \
+			node = next; \
+		} \
+		win->back = NULL; \
+		win->back_agg = (agg_identity); \
+	} /*}}}*/ \
+	static void CONCAT(function_prefix, swexpire)(window_type *win, list_type *expired) { /*{{{*/ \
+		if (win->back == win->list.first) { CONCAT(function_prefix, swflip)(win); } \
+		CONCAT(function_prefix, lpushback)(expired, CONCAT(function_prefix, lpopfront)(&win->list)); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, swinit)(window_type *win, size_t max_count, uint64_t max_age) { /*{{{*/ \
+		assert(win != NULL); \
+		CONCAT(function_prefix, lclear)(&win->list); \
+		win->back = NULL; \
+		win->back_agg = (agg_identity); \
+		win->max_count = max_count; \
+		win->max_age = max_age; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, swpush)(window_type *win, node_type *node, uint64_t now, list_type *expired) { /*{{{*/ \
+		assert(win != NULL); \
+		assert(node != NULL); \
+		assert(expired != NULL); \
+		node->sll_window.time = now; \
+		win->back_agg = agg_combine_func(win->back_agg, node_agg_func(node)); \
+		if (win->back == NULL) { win->back = node; } \
+		CONCAT(function_prefix, lpushback)(&win->list, node); \
+		while (win->max_count > 0 && win->list.n > win->max_count) { \
+			CONCAT(function_prefix, swexpire)(win, expired); \
+		} \
+		CONCAT(function_prefix, swadvance)(win, now, expired); \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, swadvance)(window_type *win, uint64_t now, list_type *expired) { /*{{{*/ \
+		assert(win != NULL); \
+		assert(expired != NULL); \
+		if (win->max_age == 0) { return; } \
+		while (win->list.first != NULL && now - win->list.first->sll_window.time >= win->max_age) { \
+			CONCAT(function_prefix, swexpire)(win, expired); \
+		} \
+	} /*}}}*/ \
+	agg_type CONCAT(function_prefix, swquery)(const window_type *win) { /*{{{*/ \
+		assert(win != NULL); \
+		if (win->back == win->list.first) { return win->back_agg; } \
+		return agg_combine_func(win->list.first->sll_window.agg, win->back_agg); \
+	} /*}}}*/ \
+	size_t CONCAT(function_prefix, swsize)(const window_type *win) { /*{{{*/ \
+		assert(win != NULL); \
+		return win->list.n; \
+	} /*}}}*/ \
+	void CONCAT(function_prefix, swclear)(window_type *win, list_type *expired) { /*{{{*/ \
+		assert(win != NULL); \
+		assert(expired != NULL); \
+		CONCAT(function_prefix, lsplice)(expired, &win->list); \
+		win->back = NULL; \
+		win->back_agg = (agg_identity); \
+	} /*}}}*/
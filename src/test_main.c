@@ -0,0 +1,1098 @@
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include "sll_meta.h"
+#include "sll_fiber.h"
+#include "sll_dag.h"
+#include "sll_graph.h"
+#include "sll_codel.h"
+#include "sll_batch.h"
+#include "sll_reseq.h"
+#include "sll_ring.h"
+#include "sll_slab.h"
+#include "sll_ingest.h"
+#include "sll_egress.h"
+#include "sll_drr.h"
+#include "sll_mlfq.h"
+#include "sll_bump.h"
+#include "sll_window.h"
+#include "sll_bcast.h"
+#include "sll_spill.h"
+#include "sll_adapt.h"
+#include "sll_locked.h"
+#include "sll_multiq.h"
+#include "sll_export.h"
+
+/*
+ * instantiates every header once and checks the basics, run by make test with the default
+ * SLL_TAG_BITS and again with SLL_TAG_BITS=3
+ */
+
+#define CHECK(_COND) do { \
+	if (!(_COND)) { \
+		fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #_COND); \
+		exit(1); \
+	} \
+} while (0)
+
+static void writeall(int fd, const void *data, size_t len) {
+	CHECK(write(fd, data, len) == (ssize_t)len);
+}
+
+// a file in the temporary directory, unlinked right away
+static int tempfd(void) {
+	char path[] = "/tmp/sll_test_XXXXXX";
+	int fd = mkstemp(path);
+	CHECK(fd >= 0);
+	unlink(path);
+	return fd;
+}
+
+// sll_meta.h
+
+typedef struct metanode {
+	SLL_LINK(metanode);
+	int id;
+} metanode;
+
+SLL_DECLS(meta, metanode, metalist);
+SLL_ITER_DECLS(meta, metanode, metalist, metaiter);
+SLL_POOL_DECLS(meta, metanode, metalist, metapool);
+
+SLL_DEFS(meta, metanode, metalist, free);
+SLL_ITER_DEFS(meta, metanode, metalist, metaiter);
+SLL_POOL_DEFS(meta, metanode, metalist, metapool);
+
+// pushes ids from to to - 1 onto list, taking the nodes from pool
+static void metafill(metapool *pool, metalist *list, int from, int to) {
+	for (int i=from; i<to; ++i) {
+		metanode *node = meta_pget(pool);
+		CHECK(node != NULL);
+		node->id = i;
+		meta_lpushback(list, node);
+	}
+}
+
+static void test_meta(void) {
+	metapool pool = {0};
+	metalist a = {0}, b = {0};
+	metafill(&pool, &a, 0, 10);
+	metafill(&pool, &b, 10, 20);
+	meta_lsplice(&a, &b);
+	CHECK(meta_lsize(&a) == 20 && meta_lsize(&b) == 0 && b.first == NULL && b.last == NULL);
+	int expect = 0;
+	for (metanode *node=a.first; node != NULL; node=SLL_NEXT(node)) { CHECK(node->id == expect++); }
+	CHECK(expect == 20 && a.last->id == 19);
+	meta_lsplice(&b, &a);
+	CHECK(meta_lsize(&b) == 20 && meta_lsize(&a) == 0 && b.first->id == 0);
+
+	// removing while iterating, from the front, the middle and the end
+	for (metaiter iter=SLL_ISTART(&b); !meta_iisend(&iter); meta_inext(&iter)) {
+		if (meta_iget(&iter)->id % 3 == 0 || meta_iget(&iter)->id == 19) { meta_preturn(&pool, meta_ipop(&iter)); }
+	}
+	CHECK(meta_lsize(&b) == 12 && meta_lsize(&pool) == 8 && b.first->id == 1 && b.last->id == 17);
+	for (metanode *node=b.first; node != NULL; node=SLL_NEXT(node)) { CHECK(node->id % 3 != 0); }
+
+	bool isnew = true;
+	metanode *node = meta_pgetm(&pool, &isnew);
+	CHECK(!isnew && meta_lsize(&pool) == 7);
+	meta_preturn(&pool, node);
+	meta_lfree(&b);
+	meta_pfree(&pool);
+	CHECK(meta_lsize(&b) == 0 && meta_lsize(&pool) == 0);
+}
+
+// sll_fiber.h
+
+typedef struct fibernode {
+	SLL_LINK(fibernode);
+	SLL_FIBER_LINK(fibernode, fibersched);
+	int id;
+} fibernode;
+
+typedef struct fiberitem {
+	SLL_LINK(fiberitem);
+	int value;
+} fiberitem;
+
+SLL_DECLS(fiber, fibernode, fiberlist);
+SLL_FIBER_DECLS(fiber, fibernode, fiberlist, fibersched, fiberwait);
+SLL_DECLS(fitem, fiberitem, fitemlist);
+SLL_FIBER_QUEUE_DECLS(fitem, fiberitem, fitemlist, fitemqueue, fiber, fiberwait);
+
+static _Atomic int fibersdone;
+static void fiberdone(fibernode *fiber) { (void)fiber; ++fibersdone; }
+
+SLL_DEFS(fiber, fibernode, fiberlist, free);
+SLL_FIBER_DEFS(fiber, fibernode, fiberlist, fibersched, fiberwait, fiberdone);
+SLL_DEFS(fitem, fiberitem, fitemlist, free);
+SLL_FIBER_QUEUE_DEFS(fitem, fiberitem, fitemlist, fitemqueue, fiber, fiberwait);
+
+static fibersched fsched;
+static fitemqueue fibertofiber, fibertothread;
+static fiberitem fitems[100];
+static int fibersum;
+
+static void fiberproducer(fibernode *fiber) {
+	(void)fiber;
+	for (int i=0; i<100; ++i) {
+		fitems[i].value = i;
+		fitem_fqpush(&fibertofiber, &fitems[i]);
+		if (i % 10 == 0) { fiber_fyield(); }
+	}
+}
+
+// takes from the producer fiber, parking while empty, and hands on to the main thread
+static void fiberconsumer(fibernode *fiber) {
+	(void)fiber;
+	fiber_fsleep(1000);
+	for (int i=0; i<100; ++i) {
+		fiberitem *item = fitem_fqpop(&fibertofiber);
+		fibersum += item->value;
+		fitem_fqpush(&fibertothread, item);
+	}
+}
+
+static void *fiberrunner(void *arg) {
+	(void)arg;
+	fiber_srun(&fsched);
+	return NULL;
+}
+
+static void test_fiber(void) {
+	static fibernode fibers[2];
+	fiber_sinit(&fsched, 0);
+	fitem_fqinit(&fibertofiber);
+	fitem_fqinit(&fibertothread);
+	CHECK(fiber_fspawn(&fsched, &fibers[0], fiberconsumer));
+	CHECK(fiber_fspawn(&fsched, &fibers[1], fiberproducer));
+	pthread_t runner;
+	CHECK(pthread_create(&runner, NULL, fiberrunner, NULL) == 0);
+	// the main thread is no fiber and blocks in fqpop instead
+	for (int i=0; i<100; ++i) { CHECK(fitem_fqpop(&fibertothread)->value == i); }
+	CHECK(pthread_join(runner, NULL) == 0);
+	CHECK(fibersdone == 2 && fibersum == 99 * 100 / 2 && fitem_fqtrypop(&fibertofiber) == NULL);
+
+	// finished fibers can be spawned again
+	CHECK(fiber_fspawn(&fsched, &fibers[0], fiberconsumer));
+	CHECK(fiber_fspawn(&fsched, &fibers[1], fiberproducer));
+	fiber_srun(&fsched);
+	CHECK(fibersdone == 4);
+	for (int i=0; i<100; ++i) { CHECK(fitem_fqtrypop(&fibertothread)->value == i); }
+	fitem_fqdestroy(&fibertofiber);
+	fitem_fqdestroy(&fibertothread);
+	fiber_sdestroy(&fsched);
+}
+
+// sll_dag.h
+
+typedef struct dagjob dagjob;
+SLL_DAG_EDGE_DECLS(dag, dagjob, dagedge, dagedgelist);
+struct dagjob {
+	SLL_LINK(dagjob);
+	SLL_DAG_LINK(dagjob, dagedgelist);
+	int id;
+	_Atomic int order;
+};
+
+SLL_DECLS(dag, dagjob, dagjoblist);
+SLL_DAG_DECLS(dag, dagjob, dagjoblist, dagedge, dagedgelist, daggraph);
+
+SLL_DEFS(dag, dagjob, dagjoblist, free);
+SLL_DAG_DEFS(dag, dagjob, dagjoblist, dagedge, dagedgelist, daggraph);
+
+static _Atomic int dagclock;
+
+static void dagvisit(dagjob *job, void *arg) {
+	(void)arg;
+	job->order = ++dagclock;
+}
+
+static void test_dag(void) {
+	daggraph graph;
+	dagjob *jobs[4];
+	dag_dinit(&graph);
+	for (int i=0; i<4; ++i) {
+		jobs[i] = calloc(1, sizeof(dagjob));
+		CHECK(jobs[i] != NULL);
+		jobs[i]->id = i;
+		dag_dadd(&graph, jobs[i]);
+	}
+	// a diamond
+	CHECK(dag_dedge(&graph, jobs[0], jobs[1]) && dag_dedge(&graph, jobs[0], jobs[2]));
+	CHECK(dag_dedge(&graph, jobs[1], jobs[3]) && dag_dedge(&graph, jobs[2], jobs[3]));
+	CHECK(dag_dsize(&graph) == 4 && dag_dacyclic(&graph));
+	for (int threads=0; threads<=2; threads+=2) {
+		if (threads > 0) { CHECK(dag_dstart(&graph, threads) == 0); }
+		for (int run=0; run<3; ++run) {
+			dagclock = 0;
+			CHECK(dag_drun(&graph, dagvisit, NULL) == 0 && dagclock == 4);
+			CHECK(jobs[0]->order < jobs[1]->order && jobs[0]->order < jobs[2]->order);
+			CHECK(jobs[1]->order < jobs[3]->order && jobs[2]->order < jobs[3]->order);
+		}
+	}
+	// workers started again must only join the runs after their start
+	for (int restart=0; restart<3; ++restart) {
+		dag_dstop(&graph);
+		CHECK(dag_dstart(&graph, 2) == 0);
+		// give them time to reach their wait before the run
+		nanosleep(&(struct timespec){ .tv_nsec=10000000 }, NULL);
+		dagclock = 0;
+		CHECK(dag_drun(&graph, dagvisit, NULL) == 0 && dagclock == 4);
+		CHECK(jobs[1]->order < jobs[3]->order && jobs[2]->order < jobs[3]->order);
+	}
+	CHECK(dag_dedge(&graph, jobs[3], jobs[0]));
+	CHECK(!dag_dacyclic(&graph) && dag_drun(&graph, dagvisit, NULL) == EDEADLK);
+	dag_dstop(&graph);
+	dag_dfree(&graph);
+}
+
+// sll_graph.h
+
+typedef struct graphedge {
+	SLL_LINK(graphedge);
+	SLL_GRAPH_LINK;
+	int weight;
+} graphedge;
+
+SLL_DECLS(graph, graphedge, graphedgelist);
+SLL_POOL_DECLS(graph, graphedge, graphedgelist, graphedgepool);
+SLL_GRAPH_DECLS(graph, graphedge, graphedgelist, graphedgepool, graphgraph);
+
+SLL_DEFS(graph, graphedge, graphedgelist, (void));
+SLL_POOL_DEFS(graph, graphedge, graphedgelist, graphedgepool);
+SLL_GRAPH_DEFS(graph, graphedge, graphedgelist, graphedgepool, graphgraph);
+
+static void test_graph(void) {
+	graphgraph graph;
+	size_t dist[6];
+	CHECK(graph_ginit(&graph, 5));
+	// 0 -> 1 -> 2 -> 3 with a shortcut 0 -> 2, 4 unreachable
+	for (size_t v=0; v<3; ++v) { graph_gedge(&graph, v, v + 1)->weight = 1; }
+	graph_gedge(&graph, 0, 2)->weight = 2;
+	graph_gedge(&graph, 3, 3)->weight = 0;
+	CHECK(graph_gvsize(&graph) == 5 && graph_gesize(&graph) == 5);
+	CHECK(graph_gremove(&graph, 3, 3) == 1 && graph_gesize(&graph) == 4);
+	CHECK(graph_lsize(graph_gout(&graph, 0)) == 2);
+	for (int round=0; round<3; ++round) {
+		if (round == 1) { CHECK(graph_gstart(&graph, 2) == 0); }
+		if (round == 2) { CHECK(graph_gfreeze(&graph) && graph_gisfrozen(&graph)); }
+		CHECK(graph_gbfs(&graph, 0, dist) == 4);
+		CHECK(dist[0] == 0 && dist[1] == 1 && dist[2] == 1 && dist[3] == 2 && dist[4] == SIZE_MAX);
+	}
+	CHECK(graph_gresize(&graph, 6));
+	graph_gedge(&graph, 3, 5);
+	CHECK(!graph_gisfrozen(&graph));
+	CHECK(graph_gbfs(&graph, 0, dist) == 5 && dist[5] == 3);
+	// workers started again must only join the searches after their start
+	for (int restart=0; restart<3; ++restart) {
+		graph_gstop(&graph);
+		CHECK(graph_gstart(&graph, 3) == 0);
+		// give them time to reach their wait before the search
+		nanosleep(&(struct timespec){ .tv_nsec=10000000 }, NULL);
+		CHECK(graph_gbfs(&graph, 0, dist) == 5 && dist[3] == 2 && dist[5] == 3);
+	}
+	graph_gstop(&graph);
+	graph_gfree(&graph);
+}
+
+// sll_codel.h
+
+typedef struct codelnode {
+	SLL_LINK(codelnode);
+	SLL_CODEL_LINK;
+	int id;
+} codelnode;
+
+SLL_DECLS(codel, codelnode, codellist);
+SLL_CODEL_DECLS(codel, codelnode, codellist, codelqueue);
+
+SLL_DEFS(codel, codelnode, codellist, free);
+SLL_CODEL_DEFS(codel, codelnode, codellist, codelqueue);
+
+static uint64_t codelnow;
+static uint64_t codelclock(void) { return codelnow; }
+
+static void test_codel(void) {
+	codelqueue queue;
+	codelnode nodes[4];
+	codel_cinit(&queue, 0, 0, codelclock);
+	for (int i=0; i<4; ++i) {
+		nodes[i].id = i;
+		codel_cpushback(&queue, &nodes[i]);
+	}
+	CHECK(codel_csize(&queue) == 4);
+	// well under the target, nothing is dropped
+	codelnow += 1000;
+	for (int i=0; i<4; ++i) { CHECK(codel_cpopfront(&queue)->id == i); }
+	CHECK(codel_cpopfront(&queue) == NULL && codel_cdrops(&queue) == 0 && codel_lsize(codel_crejects(&queue)) == 0);
+}
+
+// sll_batch.h
+
+typedef struct batchnode {
+	SLL_LINK(batchnode);
+	size_t len;
+} batchnode;
+
+static size_t batchsize(const batchnode *node) { return node->len; }
+
+SLL_DECLS(batch, batchnode, batchlist);
+SLL_BATCH_DECLS(batch, batchnode, batchlist, batcher);
+
+SLL_DEFS(batch, batchnode, batchlist, free);
+SLL_BATCH_DEFS(batch, batchnode, batchlist, batcher, batchsize);
+
+static void test_batch(void) {
+	batcher b;
+	batchlist out = {0};
+	batchnode nodes[8] = {{0}};
+	batch_binit(&b, 3, 100, 0, batch_bsplicesink, &out);
+	for (int i=0; i<7; ++i) {
+		nodes[i].len = 10;
+		CHECK(batch_bpush(&b, &nodes[i]) == (i % 3 == 2));
+	}
+	CHECK(batch_lsize(&out) == 6 && batch_bsize(&b) == 1 && batch_bbytes(&b) == 10);
+	CHECK(batch_bdeadline(&b) == UINT64_MAX && !batch_btick(&b));
+	nodes[7].len = 200;
+	CHECK(batch_bpush(&b, &nodes[7]));
+	CHECK(batch_lsize(&out) == 8 && batch_bsize(&b) == 0);
+	batch_bflush(&b);
+	CHECK(batch_lsize(&out) == 8 && out.first == &nodes[0] && out.last == &nodes[7]);
+	batch_bdestroy(&b);
+}
+
+// sll_reseq.h
+
+typedef struct reseqnode {
+	SLL_LINK(reseqnode);
+	SLL_RESEQ_LINK;
+} reseqnode;
+
+SLL_DECLS(reseq, reseqnode, reseqlist);
+SLL_RESEQ_DECLS(reseq, reseqnode, reseqlist, reseqbuffer);
+
+SLL_DEFS(reseq, reseqnode, reseqlist, free);
+SLL_RESEQ_DEFS(reseq, reseqnode, reseqlist, reseqbuffer);
+
+static void test_reseq(void) {
+	reseqbuffer buffer;
+	reseqnode nodes[4];
+	reseqlist out = {0}, empty = {0};
+	CHECK(reseq_rinit(&buffer, 5, 10));
+	for (int i=0; i<4; ++i) { nodes[i].sll_reseq_seq = 10 + (uint64_t)i; }
+	CHECK(reseq_rput(&buffer, &nodes[2]) && reseq_rrelease(&buffer, &out) == 0);
+	CHECK(reseq_rput(&buffer, &nodes[0]) && reseq_rrelease(&buffer, &out) == 1);
+	// 11 finishes without nodes, which releases 12 along with it
+	CHECK(reseq_rputlist(&buffer, 11, &empty) && reseq_rrelease(&buffer, &out) == 2);
+	CHECK(reseq_lsize(&out) == 2 && out.first == &nodes[0] && out.last == &nodes[2]);
+	CHECK(reseq_rnext(&buffer) == 13);
+	CHECK(reseq_rput(&buffer, &nodes[3]) && reseq_rwait(&buffer, &out) == 1 && out.last == &nodes[3]);
+	reseq_rclose(&buffer);
+	reseq_rdestroy(&buffer);
+}
+
+static void test_freeze(void) {
+	metapool pool = {0};
+	metalist list = {0};
+	metanode *nodes[16];
+	metafill(&pool, &list, 0, 13);
+	size_t n = meta_lfreeze(&list, nodes);
+	CHECK(n == 13 && nodes[0] == list.first && nodes[12] == list.last);
+	for (size_t i=0; i<n/2; ++i) {
+		metanode *swap = nodes[i];
+		nodes[i] = nodes[n - 1 - i];
+		nodes[n - 1 - i] = swap;
+	}
+	meta_lthaw(&list, nodes, n);
+	CHECK(meta_lsize(&list) == 13 && list.first->id == 12 && list.last->id == 0 && SLL_NEXT(list.last) == NULL);
+	int expect = 12;
+	for (metanode *node=list.first; node != NULL; node=SLL_NEXT(node)) { CHECK(node->id == expect--); }
+	metalist empty;
+	meta_lthaw(&empty, nodes, 0);
+	CHECK(meta_lsize(&empty) == 0 && empty.first == NULL);
+	meta_lfree(&list);
+	meta_pfree(&pool);
+}
+
+// sll_ring.h
+
+typedef struct ringnode {
+	SLL_LINK(ringnode);
+	int id;
+} ringnode;
+
+SLL_DECLS(ring, ringnode, ringlist);
+SLL_RING_DECLS(ring, ringnode, ringbuffer);
+
+SLL_DEFS(ring, ringnode, ringlist, free);
+SLL_RING_DEFS(ring, ringnode, ringbuffer);
+
+static void test_ring(void) {
+	ringbuffer ring;
+	ringnode nodes[9];
+	CHECK(ring_minit(&ring, 5) && ring_mcapacity(&ring) == 8);
+	for (int i=0; i<9; ++i) {
+		nodes[i].id = i;
+		CHECK(ring_mpushback(&ring, &nodes[i]) == (i < 8));
+	}
+	CHECK(ring_msize(&ring) == 8);
+	for (int i=0; i<8; ++i) { CHECK(ring_mpopfront(&ring)->id == i); }
+	CHECK(ring_mpopfront(&ring) == NULL && ring_msize(&ring) == 0);
+	ring_mdestroy(&ring);
+}
+
+// sll_slab.h
+
+typedef struct slabnode {
+	SLL_LINK(slabnode);
+	int id;
+} slabnode;
+
+SLL_DECLS(slab, slabnode, slablist);
+SLL_SLAB_DECLS(slab, slabnode, slablist, slabpool);
+
+SLL_DEFS(slab, slabnode, slablist, free);
+SLL_SLAB_DEFS(slab, slabnode, slablist, slabpool);
+
+static void test_slab(void) {
+	static slabnode *nodes[10000];
+	slabpool pool;
+	slablist list = {0};
+	slab_spinit(&pool);
+	for (int i=0; i<10000; ++i) {
+		slabnode *node = slab_spget(&pool);
+		CHECK(node != NULL);
+		node->id = i;
+		nodes[i] = node;
+	}
+	CHECK(slab_spinuse(&pool) == 10000 && slab_spslabs(&pool) > 2);
+	// with the first slab almost empty and the second half full, the second is refilled first
+	slabpool_slab *first = SLL_SLAB_OF(slabpool_slab, nodes[0]);
+	slabpool_slab *second = SLL_SLAB_OF(slabpool_slab, nodes[5000]);
+	slabpool_slab *last = SLL_SLAB_OF(slabpool_slab, nodes[9999]);
+	CHECK(first != second && second != last);
+	for (int i=1; i<10000; ++i) {
+		slabpool_slab *slab = SLL_SLAB_OF(slabpool_slab, nodes[i]);
+		if (slab == first || (slab == second && i % 2 == 0)) { slab_spreturn(&pool, nodes[i]); }
+	}
+	slabnode *node;
+	while (SLL_SLAB_OF(slabpool_slab, node = slab_spget(&pool)) == last) { }
+	CHECK(SLL_SLAB_OF(slabpool_slab, node) == second);
+	for (slabnode *prev = node; SLL_SLAB_OF(slabpool_slab, node = slab_spget(&pool)) == second; prev = node) {
+		CHECK(node > prev);
+	}
+	CHECK(SLL_SLAB_OF(slabpool_slab, node) == first);
+	slab_spfree(&pool);
+	slab_spinit(&pool);
+	for (int i=0; i<10000; ++i) {
+		node = slab_spget(&pool);
+		CHECK(node != NULL);
+		node->id = i;
+		slab_lpushback(&list, node);
+	}
+	while (slab_lsize(&list) > 0) { slab_spreturn(&pool, slab_lpopfront(&list)); }
+	CHECK(slab_spinuse(&pool) == 0);
+	CHECK(slab_sptrim(&pool) > 0 && slab_spslabs(&pool) == 0);
+	CHECK(slab_spget(&pool) != NULL && slab_spinuse(&pool) == 1);
+	slab_spfree(&pool);
+}
+
+// sll_ingest.h
+
+typedef struct ingestnode {
+	SLL_LINK(ingestnode);
+	SLL_INGEST_LINK;
+} ingestnode;
+
+SLL_DECLS(ingest, ingestnode, ingestlist);
+SLL_POOL_DECLS(ingest, ingestnode, ingestlist, ingestpool);
+SLL_INGEST_DECLS(ingest, ingestnode, ingestlist, ingestpool, ingestmapping);
+
+SLL_DEFS(ingest, ingestnode, ingestlist, free);
+SLL_POOL_DEFS(ingest, ingestnode, ingestlist, ingestpool);
+SLL_INGEST_DEFS(ingest, ingestnode, ingestlist, ingestpool, ingestmapping);
+
+static void ingestfile(const char *path, const void *data, size_t len) {
+	int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	CHECK(fd >= 0);
+	writeall(fd, data, len);
+	close(fd);
+}
+
+static void test_ingest(void) {
+	ingestpool pool = {0};
+	ingestlist list = {0};
+	ingestmapping map;
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/sll_test_%d", (int)getpid());
+
+	ingestfile(path, "one\ntwo\n\nthree", 14);
+	CHECK(ingest_inmap(&map, path) == 0);
+	CHECK(ingest_insplit(&map, &pool, &list, '\n') == 4 && ingest_inleft(&map) == 0);
+	const char *records[] = { "one", "two", "", "three" };
+	size_t i = 0;
+	for (ingestnode *node=list.first; node != NULL; node=SLL_NEXT(node), ++i) {
+		CHECK(node->sll_ingest_len == strlen(records[i]) && memcmp(node->sll_ingest_data, records[i], node->sll_ingest_len) == 0);
+	}
+	ingest_inunmap(&map);
+	ingest_lsplice(&pool, &list);
+
+	// two frames and a truncated one
+	ingestfile(path, "\x00\x02" "hi" "\x00\x03" "abc" "\x00\x09" "xy", 13);
+	CHECK(ingest_inmap(&map, path) == 0);
+	CHECK(ingest_inframes(&map, &pool, &list, 2) == 2 && ingest_inleft(&map) == 4);
+	CHECK(list.first->sll_ingest_len == 2 && memcmp(list.last->sll_ingest_data, "abc", 3) == 0);
+	ingest_inunmap(&map);
+	unlink(path);
+	CHECK(ingest_inmap(&map, path) == ENOENT);
+	ingest_lfree(&list);
+	ingest_pfree(&pool);
+}
+
+// sll_egress.h
+
+typedef struct egressnode {
+	SLL_LINK(egressnode);
+	SLL_EGRESS_LINK;
+} egressnode;
+
+SLL_DECLS(egress, egressnode, egresslist);
+SLL_POOL_DECLS(egress, egressnode, egresslist, egresspool);
+SLL_EGRESS_DECLS(egress, egressnode, egresslist, egresspool);
+
+SLL_DEFS(egress, egressnode, egresslist, free);
+SLL_POOL_DEFS(egress, egressnode, egresslist, egresspool);
+SLL_EGRESS_DEFS(egress, egressnode, egresslist, egresspool);
+
+static void test_egress(void) {
+	egresspool pool = {0};
+	egresslist list = {0};
+	int file = tempfd();
+	writeall(file, "0123456789", 10);
+	egressnode *node = egress_pget(&pool);
+	egress_esetbuf(node, "head:", 5);
+	egress_lpushback(&list, node);
+	node = egress_pget(&pool);
+	egress_esetfile(node, file, 2, 6);
+	egress_lpushback(&list, node);
+	node = egress_pget(&pool);
+	egress_esetbuf(node, ":tail", 5);
+	egress_lpushback(&list, node);
+	CHECK(egress_elen(&list) == 16);
+
+	int out = tempfd();
+	CHECK(egress_esend(&list, &pool, out) == 16);
+	CHECK(egress_lsize(&list) == 0 && egress_lsize(&pool) == 3);
+	char buf[32] = {0};
+	CHECK(pread(out, buf, sizeof(buf), 0) == 16 && memcmp(buf, "head:234567:tail", 16) == 0);
+	close(out);
+	close(file);
+	egress_pfree(&pool);
+}
+
+// sll_drr.h
+
+typedef struct drrnode {
+	SLL_LINK(drrnode);
+	int flow;
+	size_t cost;
+} drrnode;
+
+static size_t drrcost(const drrnode *node) { return node->cost; }
+
+SLL_DECLS(drr, drrnode, drrlist);
+SLL_DRR_DECLS(drr, drrnode, drrlist, drrflow, drrsched);
+
+SLL_DEFS(drr, drrnode, drrlist, free);
+SLL_DRR_DEFS(drr, drrnode, drrlist, drrflow, drrsched, drrcost);
+
+static void test_drr(void) {
+	drrsched sched;
+	drrflow flows[2];
+	drrnode nodes[8];
+	drr_drinit(&sched);
+	drr_drflowinit(&flows[0], 100);
+	drr_drflowinit(&flows[1], 100);
+	for (int i=0; i<8; ++i) {
+		nodes[i].flow = i < 4 ? 0 : 1;
+		nodes[i].cost = 100;
+		drr_drpush(&sched, &flows[nodes[i].flow], &nodes[i]);
+	}
+	CHECK(drr_drsize(&sched) == 8 && drr_dractive(&sched) == 2);
+	// a quantum a round each, so the flows take turns
+	int last = -1;
+	for (int i=0; i<8; ++i) {
+		drrnode *node = drr_drpop(&sched);
+		CHECK(node != NULL && node->flow != last);
+		last = node->flow;
+	}
+	CHECK(drr_drpop(&sched) == NULL && drr_drsize(&sched) == 0 && drr_dractive(&sched) == 0);
+}
+
+// sll_mlfq.h
+
+typedef struct mlfqtask {
+	SLL_LINK(mlfqtask);
+	SLL_MLFQ_LINK;
+	int id;
+} mlfqtask;
+
+SLL_DECLS(mlfq, mlfqtask, mlfqlist);
+SLL_MLFQ_DECLS(mlfq, mlfqtask, mlfqlist, mlfqsched);
+
+SLL_DEFS(mlfq, mlfqtask, mlfqlist, free);
+SLL_MLFQ_DEFS(mlfq, mlfqtask, mlfqlist, mlfqsched);
+
+static void test_mlfq(void) {
+	mlfqsched sched;
+	mlfqtask hog = { .id=0 }, interactive = { .id=1 };
+	mlfq_mqinit(&sched, 3, 10, 100);
+	mlfq_mqpush(&sched, &hog);
+	mlfq_mqpush(&sched, &interactive);
+	CHECK(mlfq_mqsize(&sched) == 2);
+
+	// the hog uses up its quantum and drops a level, the other task stays ahead of it
+	mlfqtask *task = mlfq_mqpop(&sched);
+	CHECK(task == &hog && task->sll_mlfq.level == 0);
+	mlfq_mqrequeue(&sched, task, mlfq_mqquantum(&sched, task));
+	task = mlfq_mqpop(&sched);
+	CHECK(task == &interactive);
+	mlfq_mqrequeue(&sched, task, 1);
+	CHECK(mlfq_mqpop(&sched) == &interactive);
+	mlfq_mqrequeue(&sched, &interactive, 1);
+
+	// the first tick only starts the boost period
+	CHECK(!mlfq_mqtick(&sched, 1000000) && !mlfq_mqtick(&sched, 1000050));
+	CHECK(mlfq_mqtick(&sched, 1000100) && !mlfq_mqtick(&sched, 1000150));
+	task = mlfq_mqpop(&sched);
+	CHECK(task->sll_mlfq.level == 0);
+	CHECK(mlfq_mqpop(&sched)->sll_mlfq.level == 0 && mlfq_mqpop(&sched) == NULL);
+}
+
+// static nodes are never freed, so the no-op free is fine for them
+typedef struct statnode {
+	SLL_LINK(statnode);
+	const char *name;
+} statnode;
+
+SLL_DECLS(stat, statnode, statlist);
+SLL_DEFS(stat, statnode, statlist, (void));
+
+static statnode stattail;
+static statnode statmid = SLL_STATIC_NODE(&stattail, .name="mid");
+static statnode stathead = SLL_STATIC_NODE(&statmid, .name="head");
+static statnode stattail = SLL_STATIC_NODE(NULL, .name="tail");
+static statlist statchain = SLL_STATIC_LIST(&stathead, &stattail, 3);
+static statnode statarray[3] = {
+	SLL_STATIC_ANODE(statarray, 3, 0, .name="a"),
+	SLL_STATIC_ANODE(statarray, 3, 1, .name="b"),
+	SLL_STATIC_ANODE(statarray, 3, 2, .name="c"),
+};
+static statlist statregistry = SLL_STATIC_ALIST(statarray, 3);
+
+static void test_static(void) {
+	const char *names[] = { "head", "mid", "tail", "a", "b", "c" };
+	size_t i = 0;
+	for (statnode *node=statchain.first; node != NULL; node=SLL_NEXT(node)) { CHECK(strcmp(node->name, names[i++]) == 0); }
+	for (statnode *node=statregistry.first; node != NULL; node=SLL_NEXT(node)) { CHECK(strcmp(node->name, names[i++]) == 0); }
+	CHECK(i == 6 && stat_lsize(&statregistry) == 3 && statregistry.last == &statarray[2]);
+	stat_lsplice(&statchain, &statregistry);
+	CHECK(stat_lsize(&statchain) == 6 && statchain.last == &statarray[2]);
+}
+
+// sll_bump.h
+
+typedef struct bumpnode {
+	SLL_LINK(bumpnode);
+	char data[40];
+} bumpnode;
+
+SLL_DECLS(bump, bumpnode, bumplist);
+SLL_BUMP_DECLS(bump, bumpnode, bumplist, bumppool);
+
+SLL_DEFS(bump, bumpnode, bumplist, free);
+SLL_BUMP_DEFS(bump, bumpnode, bumplist, bumppool);
+
+static void test_bump(void) {
+	bumppool pool;
+	bumplist list = {0};
+	bump_bpinit(&pool, 16);
+	for (int i=0; i<40; ++i) {
+		bumpnode *node = bump_bpget(&pool);
+		CHECK(node != NULL);
+		memset(node->data, i, sizeof(node->data));
+		bump_lpushback(&list, node);
+	}
+	CHECK(bump_bpreserved(&pool) >= 40 && bump_bptouched(&pool) == 40);
+	while (bump_lsize(&list) > 0) { bump_bpreturn(&pool, bump_lpopfront(&list)); }
+	for (int i=0; i<40; ++i) { CHECK(bump_bpget(&pool) != NULL); }
+	CHECK(bump_bptouched(&pool) == 40);
+	bump_bpfree(&pool);
+}
+
+// sll_window.h
+
+typedef struct windownode {
+	SLL_LINK(windownode);
+	SLL_WINDOW_LINK(sll_window_stats);
+	int64_t sample;
+} windownode;
+
+static sll_window_stats windowsample(const windownode *node) { return sll_window_stats_of(node->sample); }
+
+SLL_DECLS(window, windownode, windowlist);
+SLL_WINDOW_DECLS(window, windownode, windowlist, windowwin, sll_window_stats);
+
+SLL_DEFS(window, windownode, windowlist, free);
+SLL_WINDOW_DEFS(window, windownode, windowlist, windowwin, sll_window_stats, SLL_WINDOW_STATS_IDENTITY, sll_window_stats_combine, windowsample);
+
+static void test_window(void) {
+	windowwin win;
+	windowlist expired = {0};
+	windownode nodes[5];
+	const int64_t samples[5] = { 5, -2, 9, 1, 4 };
+	window_swinit(&win, 3, 10);
+	for (int i=0; i<5; ++i) {
+		nodes[i].sample = samples[i];
+		window_swpush(&win, &nodes[i], (uint64_t)i, &expired);
+	}
+	sll_window_stats stats = window_swquery(&win);
+	CHECK(window_swsize(&win) == 3 && window_lsize(&expired) == 2);
+	CHECK(stats.count == 3 && stats.sum == 14 && stats.min == 1 && stats.max == 9);
+	// pushed at 2, 3 and 4, so at 13 only the last one is left
+	window_swadvance(&win, 13, &expired);
+	stats = window_swquery(&win);
+	CHECK(window_swsize(&win) == 1 && stats.sum == 4 && stats.min == 4);
+	window_swclear(&win, &expired);
+	CHECK(window_swsize(&win) == 0 && window_swquery(&win).count == 0 && window_lsize(&expired) == 5);
+}
+
+// sll_bcast.h
+
+typedef struct bcastnode {
+	SLL_LINK(bcastnode);
+	SLL_BCAST_LINK;
+	int id;
+} bcastnode;
+
+SLL_DECLS(bcast, bcastnode, bcastlist);
+SLL_POOL_DECLS(bcast, bcastnode, bcastlist, bcastpool);
+SLL_BCAST_DECLS(bcast, bcastnode, bcastlist, bcastpool, bcaster, bcastconsumer);
+
+SLL_DEFS(bcast, bcastnode, bcastlist, free);
+SLL_POOL_DEFS(bcast, bcastnode, bcastlist, bcastpool);
+SLL_BCAST_DEFS(bcast, bcastnode, bcastlist, bcastpool, bcaster, bcastconsumer);
+
+static void test_bcast(void) {
+	bcaster bc;
+	bcastpool pool = {0};
+	bcastconsumer first, second;
+	CHECK(bcast_bcinit(&bc));
+	bcast_bcjoin(&bc, &first);
+	bcast_bcjoin(&bc, &second);
+	for (int i=0; i<5; ++i) {
+		bcastnode *node = bcast_pget(&pool);
+		node->id = i;
+		bcast_bcpush(&bc, node);
+	}
+	for (int i=0; i<5; ++i) { CHECK(bcast_bcnext(&first)->id == i); }
+	CHECK(bcast_bcnext(&first) == NULL);
+	// second still holds all of them back
+	CHECK(bcast_bcreclaim(&bc, &pool) == 0 && bcast_bcsize(&bc) == 5);
+	// a consumer stands on the node it read last, which keeps that one
+	for (int i=0; i<3; ++i) { CHECK(bcast_bcnext(&second)->id == i); }
+	CHECK(bcast_bcreclaim(&bc, &pool) == 2 && bcast_bcsize(&bc) == 3);
+	bcast_bcleave(&bc, &second);
+	bcast_bcclose(&bc);
+	CHECK(bcast_bcwait(&bc, &first) == NULL);
+	bcast_bcleave(&bc, &first);
+	bcast_bcdestroy(&bc, &pool);
+	CHECK(bcast_lsize(&pool) == 5);
+	bcast_pfree(&pool);
+}
+
+// sll_spill.h
+
+typedef struct spillnode {
+	SLL_LINK(spillnode);
+	uint64_t value;
+} spillnode;
+
+static size_t spillencode(const spillnode *node, void *buf) {
+	memcpy(buf, &node->value, sizeof(node->value));
+	return sizeof(node->value);
+}
+
+static bool spilldecode(spillnode *node, const void *buf, size_t len) {
+	if (len != sizeof(node->value)) { return false; }
+	memcpy(&node->value, buf, len);
+	return true;
+}
+
+SLL_DECLS(spill, spillnode, spilllist);
+SLL_POOL_DECLS(spill, spillnode, spilllist, spillpool);
+SLL_SPILL_DECLS(spill, spillnode, spilllist, spillpool, spillqueue);
+
+SLL_DEFS(spill, spillnode, spilllist, free);
+SLL_POOL_DEFS(spill, spillnode, spilllist, spillpool);
+SLL_SPILL_DEFS(spill, spillnode, spilllist, spillpool, spillqueue, spillencode, spilldecode);
+
+static void test_spill(void) {
+	spillpool pool = {0};
+	spillqueue queue;
+	CHECK(spill_dqopen(&queue, "/tmp", 8, 4) == 0);
+	for (uint64_t i=0; i<100; ++i) {
+		spillnode *node = spill_pget(&pool);
+		node->value = i;
+		CHECK(spill_dqpush(&queue, &pool, node) == 0);
+	}
+	CHECK(spill_dqsize(&queue) == 100 && spill_dqspilled(&queue) > 0);
+	for (uint64_t i=0; i<100; ++i) {
+		spillnode *node = spill_dqpop(&queue, &pool);
+		CHECK(node != NULL && node->value == i);
+		spill_preturn(&pool, node);
+	}
+	CHECK(spill_dqpop(&queue, &pool) == NULL && spill_dqsize(&queue) == 0);
+	spill_dqclose(&queue, &pool);
+	spill_pfree(&pool);
+}
+
+static void test_ptrim(void) {
+	metapool pool = {0};
+	metalist list = {0};
+	metafill(&pool, &list, 0, 8);
+	while (meta_lsize(&list) > 0) { meta_preturn(&pool, meta_lpopfront(&list)); }
+	CHECK(meta_ptrim(&pool, 10) == 0 && meta_lsize(&pool) == 8);
+	CHECK(meta_ptrim(&pool, 3) == 5 && meta_lsize(&pool) == 3);
+	CHECK(meta_ptrim(&pool, 0) == 3 && meta_lsize(&pool) == 0);
+	meta_pfree(&pool);
+}
+
+// sll_adapt.h
+
+typedef struct adaptnode {
+	SLL_LINK(adaptnode);
+	int id;
+} adaptnode;
+
+SLL_DECLS(adapt, adaptnode, adaptlist);
+SLL_ADAPT_DECLS(adapt, adaptnode, adaptlist, adaptqueue, adaptproducer);
+
+SLL_DEFS(adapt, adaptnode, adaptlist, free);
+SLL_ADAPT_DEFS(adapt, adaptnode, adaptlist, adaptqueue, adaptproducer);
+
+static void test_adapt(void) {
+	adaptqueue queue;
+	adaptproducer producer;
+	adaptnode nodes[100];
+	adapt_aqinit(&queue);
+	adapt_aqattach(&queue, &producer);
+	CHECK(adapt_aqpop(&queue) == NULL);
+	for (int i=0; i<100; ++i) {
+		nodes[i].id = i;
+		adapt_aqpush(&queue, &producer, &nodes[i]);
+	}
+	for (int i=0; i<100; ++i) {
+		adaptnode *node = adapt_aqpop(&queue);
+		CHECK(node != NULL && node->id == i);
+	}
+	CHECK(adapt_aqpop(&queue) == NULL);
+	adapt_aqdetach(&queue, &producer);
+}
+
+// sll_locked.h
+
+typedef struct lockednode {
+	SLL_LINK(lockednode);
+	int id;
+} lockednode;
+
+static bool lockedodd(const lockednode *node, void *arg) {
+	(void)arg;
+	return node->id % 2 != 0;
+}
+
+SLL_DECLS(locked, lockednode, lockedlist);
+SLL_LOCKED_DECLS(locked, lockednode, lockedlist, lockedqueue);
+
+SLL_DEFS(locked, lockednode, lockedlist, free);
+SLL_LOCKED_DEFS(locked, lockednode, lockedlist, lockedqueue);
+
+static void test_locked(void) {
+	lockedqueue a, b;
+	lockednode nodes[10];
+	CHECK(locked_lkinit(&a) && locked_lkinit(&b));
+	for (int i=0; i<10; ++i) {
+		nodes[i].id = i;
+		locked_lkpush(&a, &nodes[i]);
+	}
+	CHECK(locked_lkmoveif(&a, &b, lockedodd, NULL) == 5);
+	CHECK(locked_lksize(&a) == 5 && locked_lksize(&b) == 5);
+	CHECK(locked_lkmove(&a, &b, &nodes[4]) && !locked_lkmove(&a, &b, &nodes[4]));
+	CHECK(locked_lkmovefirst(&a, &b) == &nodes[0]);
+	CHECK(locked_lkmoveall(&b, &a) == 7 && locked_lksize(&a) == 10 && locked_lksize(&b) == 0);
+	CHECK(locked_lkpop(&a) == &nodes[2] && locked_lkpop(&b) == NULL);
+	locked_lkdestroy(&a);
+	locked_lkdestroy(&b);
+}
+
+// sll_multiq.h
+
+typedef struct multiqnode {
+	SLL_LINK(multiqnode);
+	uint64_t prio;
+} multiqnode;
+
+static uint64_t multiqkey(const multiqnode *node) { return node->prio; }
+
+SLL_DECLS(multiq, multiqnode, multiqlist);
+SLL_MULTIQ_DECLS(multiq, multiqnode, multiqlist, multiqueue);
+
+SLL_DEFS(multiq, multiqnode, multiqlist, free);
+SLL_MULTIQ_DEFS(multiq, multiqnode, multiqlist, multiqueue, multiqkey);
+
+static void test_multiq(void) {
+	multiqueue queue;
+	multiqnode nodes[100];
+	uint64_t sum = 0;
+	CHECK(multiq_rqinit(&queue, 4));
+	for (int i=0; i<100; ++i) {
+		nodes[i].prio = (uint64_t)(i * 37 % 100);
+		multiq_rqpush(&queue, &nodes[i]);
+	}
+	CHECK(multiq_rqsize(&queue) == 100);
+	multiqnode *node;
+	while ((node = multiq_rqpop(&queue)) != NULL) { sum += node->prio; }
+	CHECK(sum == 99 * 100 / 2 && multiq_rqsize(&queue) == 0);
+	// with a single list the order is exact
+	multiq_rqdestroy(&queue);
+	CHECK(multiq_rqinit(&queue, 1));
+	for (int i=0; i<100; ++i) { multiq_rqpush(&queue, &nodes[i]); }
+	for (uint64_t i=0; i<100; ++i) { CHECK(multiq_rqpop(&queue)->prio == i); }
+	multiq_rqdestroy(&queue);
+}
+
+static void test_tags(void) {
+	metapool pool = {0};
+	metalist a = {0}, b = {0};
+	metanode *nodes[20];
+	metafill(&pool, &a, 0, 10);
+	metafill(&pool, &b, 10, 20);
+	for (metanode *node=a.first; node != NULL; node=SLL_NEXT(node)) {
+		CHECK(meta_ltags(node) == 0);
+		meta_lsettags(node, (unsigned)node->id & SLL_TAG_MASK);
+	}
+	for (metanode *node=b.first; node != NULL; node=SLL_NEXT(node)) { meta_lsettags(node, (unsigned)node->id & SLL_TAG_MASK); }
+
+	// splicing, removing while iterating and thawing all relink nodes, the tags stay with them
+	meta_lsplice(&a, &b);
+	for (metaiter iter=SLL_ISTART(&a); !meta_iisend(&iter); meta_inext(&iter)) {
+		if (meta_iget(&iter)->id % 3 == 0) { meta_preturn(&pool, meta_ipop(&iter)); }
+	}
+	size_t n = meta_lfreeze(&a, nodes);
+	CHECK(n == 13);
+	meta_lthaw(&a, nodes + 1, n - 1);
+	meta_lpushback(&a, nodes[0]);
+	CHECK(a.first->id == 2 && a.last->id == 1 && SLL_NEXT(a.last) == NULL);
+	for (metanode *node=a.first; node != NULL; node=SLL_NEXT(node)) {
+		CHECK(node->id % 3 != 0 && meta_ltags(node) == ((unsigned)node->id & SLL_TAG_MASK));
+	}
+	meta_lfree(&a);
+	meta_pfree(&pool);
+}
+
+// sll_export.h
+
+typedef struct exportnode {
+	SLL_LINK(exportnode);
+	uint64_t id;
+	char name[16];
+} exportnode;
+
+static uint64_t exportkey(const exportnode *node) { return node->id; }
+
+static size_t exportencode(const exportnode *node, void *buf) {
+	size_t len = strlen(node->name);
+	memcpy(buf, node->name, len);
+	return len;
+}
+
+static bool exportdecode(exportnode *node, uint64_t id, const void *buf, size_t len) {
+	if (len >= sizeof(node->name)) { return false; }
+	node->id = id;
+	memcpy(node->name, buf, len);
+	node->name[len] = '\0';
+	return true;
+}
+
+SLL_DECLS(export, exportnode, exportlist);
+SLL_POOL_DECLS(export, exportnode, exportlist, exportpool);
+SLL_EXPORT_DECLS(export, exportnode, exportlist, exportpool);
+
+SLL_DEFS(export, exportnode, exportlist, free);
+SLL_POOL_DEFS(export, exportnode, exportlist, exportpool);
+SLL_EXPORT_DEFS(export, exportnode, exportlist, exportpool, exportkey, exportencode, exportdecode);
+
+static void test_export(void) {
+	exportpool pool = {0};
+	exportlist list = {0}, copy = {0};
+	for (int i=0; i<1000; ++i) {
+		exportnode *node = export_pget(&pool);
+		// mostly ascending, with a few large jumps back
+		node->id = i % 100 == 50 ? UINT64_MAX - (uint64_t)i : 1000 + (uint64_t)i * 3;
+		snprintf(node->name, sizeof(node->name), "n%d", i);
+		export_lpushback(&list, node);
+	}
+	int fd = tempfd();
+	CHECK(export_xexport(&list, fd) == 0);
+	off_t size = lseek(fd, 0, SEEK_CUR);
+	CHECK(lseek(fd, 0, SEEK_SET) == 0);
+	CHECK(export_ximport(&copy, &pool, fd) == 0);
+	CHECK(export_lsize(&copy) == 1000);
+	for (exportnode *a=list.first, *b=copy.first; a != NULL; a=SLL_NEXT(a), b=SLL_NEXT(b)) {
+		CHECK(a->id == b->id && strcmp(a->name, b->name) == 0);
+	}
+
+	// a flipped byte fails the import and leaves the list alone
+	unsigned char byte;
+	CHECK(pread(fd, &byte, 1, size / 2) == 1);
+	byte ^= 1;
+	CHECK(pwrite(fd, &byte, 1, size / 2) == 1);
+	CHECK(lseek(fd, 0, SEEK_SET) == 0);
+	CHECK(export_ximport(&copy, &pool, fd) == EIO && export_lsize(&copy) == 1000);
+	close(fd);
+	export_lfree(&list);
+	export_lfree(&copy);
+	export_pfree(&pool);
+}
+
+int main(void) {
+	test_meta();
+	test_fiber();
+	test_dag();
+	test_graph();
+	test_codel();
+	test_batch();
+	test_reseq();
+	test_freeze();
+	test_ring();
+	test_slab();
+	test_ingest();
+	test_egress();
+	test_drr();
+	test_mlfq();
+	test_static();
+	test_bump();
+	test_window();
+	test_bcast();
+	test_spill();
+	test_ptrim();
+	test_adapt();
+	test_locked();
+	test_multiq();
+	test_tags();
+	test_export();
+	printf("all tests passed (SLL_TAG_BITS=%d)\n", SLL_TAG_BITS);
+	return 0;
+}